@@ -8,6 +8,32 @@ typedef struct {
     f32 x, y, z, rotation;
 } transform_component;
 
+// Lanes line up with transform_component (x, y, z, rotation) so a body integrates with 4 wide math
+typedef struct {
+    f32 velocity_x, velocity_y, velocity_z, angular_velocity;              // Units (degrees) per second
+    f32 acceleration_x, acceleration_y, acceleration_z, angular_acceleration;
+    f32 linear_damping;  // Velocity is scaled by 1 / (1 + damping * dt) every step, 0 for none
+    f32 angular_damping;
+    f32 padding[2];      // Keeps the size a multiple of 16 bytes
+} rigidbody_component;
+
+typedef enum {
+    COLLIDER_SHAPE_AABB,
+    COLLIDER_SHAPE_CIRCLE
+} collider_shape;
+
+// Two colliders touch only if each one's layer is in the other's mask
+typedef struct {
+    u32 shape;
+    u32 layer;    // Layer bits this collider is on
+    u32 mask;     // Layer bits it collides with
+    f32 offset_x; // Center relative to the transform
+    f32 offset_y;
+    f32 half_width;  // AABB extents
+    f32 half_height;
+    f32 radius;      // Circle radius
+} collider_component;
+
 typedef void (*on_create_fn)(entity_id);
 typedef void (*on_update_fn)(entity_id, float);
 typedef void (*on_destroy_fn)(entity_id);
@@ -34,6 +60,7 @@ typedef union {
 
 typedef struct {
 	u8 is_animated;
+	u8 is_static;  // Kept in a retained batch by ecs_draw_sprites, only rewritten when it changes
 
 	i32 width;
 	i32 height;
@@ -1,124 +1,650 @@
 #include <ECS/ecs.h>
 
 #include <renderer/renderer2D.h>
+#include <renderer/texture_array.h>
+#include <core/thread.h>
+#include <core/radix_sort.h>
 #include <octomath/radians.h>
 
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 
 // -- INTERNAL STRUCTURES --
 
+// Components are stored in archetype tables, one table per combination of components.
+// Each table is split into fixed-size chunks, and every chunk holds the entity id column
+// followed by one tightly packed column per component (SoA), so systems only ever touch
+// entities that actually have the components they need.
+
+#define ECS_CHUNK_SIZE (16 * 1024)
+#define ECS_COLUMN_ALIGNMENT 16
+#define ECS_ARCHETYPE_COUNT (1 << ECS_COMPONENT_COUNT)
+#define ECS_STATIC_SPRITE_CAPACITY 256
+
+typedef struct {
+    entity_components mask;
+    u32 chunk_capacity;                       // Rows per chunk, 0 if the archetype was never created
+    u32 column_offsets[ECS_COMPONENT_COUNT];  // Byte offset of each component column inside a chunk
+    u8** chunks;                              // Chunks are kept around once allocated and reused
+    u32 chunk_count;
+    u32 chunk_reserved;
+    u32 entity_count;
+} archetype;
+
+struct ecs_query {
+    entity_components with;
+    entity_components without;
+    u32 archetype_masks[ECS_ARCHETYPE_COUNT]; // Matching archetypes, kept up to date as archetypes are created
+    u32 archetype_count;
+    ecs_query* next;
+};
+
+#define ECS_ROW_PENDING 0xFFFFFFFF // Row of an id reserved by a command buffer that was not played back yet
+#define ECS_SLOT_PAGE_SIZE 16384   // Slots per page
+#define ECS_SLOT_PAGE_COUNT 4096   // Up to 64M entities alive at once
+
+typedef struct {
+    u32 generation;
+    u32 archetype;  // Component mask of the archetype the entity lives in
+    u32 row;        // Row inside that archetype
+} entity_slot;
+
+typedef enum {
+    ECS_COMMAND_CREATE,
+    ECS_COMMAND_ADD_COMPONENT,
+    ECS_COMMAND_REMOVE_COMPONENT
+} ecs_command_type;
+
+typedef struct {
+    ecs_command_type type;
+    entity_components component;
+    entity_id entity;
+    u32 data_offset;  // Offset of the component data in the buffer's data block
+} ecs_command;
+
+struct ecs_command_buffer {
+    ecs_command* commands;
+    u32 command_count;
+    u32 command_capacity;
+
+    u8* data;
+    u32 data_size;
+    u32 data_capacity;
+
+    // Destroys are kept apart so playback can apply them last, in one sorted batch
+    entity_id* destroys;
+    u32 destroy_count;
+    u32 destroy_capacity;
+};
+
 typedef struct {
-	entity_id id;
-	entity_components components;
-} entity_record;
+    u32 archetype;
+    u32 row;
+    entity_id entity;
+} pending_destroy;
 
 typedef struct {
-	entity_record* entities;
-	u32 entity_count;
+    const transform_component* transform;
+    const sprite_component* sprite;
+} sprite_draw;
+
+typedef struct {
+    // Slots live in fixed size pages allocated on first use, so a slot never moves once handed out
+    entity_slot* slot_pages[ECS_SLOT_PAGE_COUNT];
+    mutex slot_lock;   // Command buffers on worker threads reserve ids concurrently
+    u32* free_slots;   // Stack of slots released by entity_destroy
+    u32 free_slot_count;
+    u32 free_slot_capacity;
+    u32 slot_count;    // Number of slots handed out so far
+    u32 entity_count;
+
+    archetype archetypes[ECS_ARCHETYPE_COUNT];  // Indexed by component mask, created lazily
+    u32 archetype_masks[ECS_ARCHETYPE_COUNT];   // Masks of the archetypes created so far
+    u32 archetype_count;
 
-    transform_component* transforms;
-    script_component* scripts;
-    custom_component* custom_components;
-    sprite_component* sprite_components;
+    ecs_query* queries;  // Every live query, notified when a new archetype is created
+    ecs_query* script_query;
+    ecs_query* sprite_query;
+
+    // While defer_depth is non zero structural changes are recorded instead of applied
+    u32 defer_depth;
+    ecs_command_buffer* deferred;
+    ecs_command_buffer* deferred_spare;
+
+    pending_destroy* destroy_scratch;
+    u32 destroy_scratch_capacity;
+
+    // Sort scratch of ecs_draw_sprites, kept between frames
+    sprite_draw* sprite_draws;
+    u64* sprite_keys;
+    u64* sprite_temp_keys;
+    u32* sprite_order;
+    u32* sprite_temp_order;
+    u32 sprite_capacity;
+
+    renderer2D_static_batch* static_sprites;  // Sprites with is_static set, created on first use
 } entity_registry;
 
 // -- INTERNAL STRUCTURES --
 
 // -- INTERNAL GLOBAL VARIABLES --
 
-#define MAX_ENTITIES 10000
 static entity_registry registry;
 
+// Indexed by component bit position, a size of 0 means the component is a tag with no data
+static const u32 component_sizes[ECS_COMPONENT_COUNT] = {
+    sizeof(transform_component),
+    sizeof(rigidbody_component),
+    sizeof(sprite_component),
+    sizeof(script_component),
+    sizeof(custom_component),
+    sizeof(collider_component)
+};
+
 // -- INTERNAL GLOBAL VARIABLES --
 
 // -- HELPERS --
 
-// Basically just a BIG random number generator for generating super long numbers
-static uint64_t splitmix64_state = 0xA5A5A5A5A5A5A5A5;
+static u32 component_index(entity_components component) {
+    u32 index = 0;
+    while (index < ECS_COMPONENT_COUNT && !(component & (1 << index))) {
+        index++;
+    }
+    return index;
+}
 
-uint64_t generate_random_u64() {
-    uint64_t z = (splitmix64_state += 0x9E3779B97F4A7C15);
-    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
-    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
-    return z ^ (z >> 31);
+static u32 align_up(u32 value, u32 alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
 }
 
-static entity_id generate_uuid() {
-    entity_id id = generate_random_u64();
-    return id != 0 ? id : generate_uuid(); // Avoid 0
+static entity_slot* internal_slot_at(u32 slot) {
+    return &registry.slot_pages[slot / ECS_SLOT_PAGE_SIZE][slot % ECS_SLOT_PAGE_SIZE];
 }
 
-static void transform_system_update(entity_id id, u32 index) {
-    registry.transforms[index].x += 1.0f; // TODO: Delta time
+// Resolves a (possibly stale) entity id to its slot in O(1)
+static entity_slot* internal_get_slot(entity_id entity) {
+    u32 slot = entity_id_slot(entity);
+
+    if (entity == ENTITY_NULL || slot >= registry.slot_count) return NULL;
+
+    entity_slot* entry = internal_slot_at(slot);
+    if (entry->generation != entity_id_generation(entity)) return NULL; // Stale handle
+    if (entry->row == ECS_ROW_PENDING) return NULL; // Reserved but not created yet
+
+    return entry;
+}
+
+// NULL if the allocation fails, array and capacity are then left as they were
+static void* internal_grow(void* array, u32* capacity, u32 required, u32 element_size) {
+    if (required <= *capacity) return array;
+
+    u32 new_capacity = *capacity ? *capacity : 64;
+    while (new_capacity < required) {
+        new_capacity *= 2;
+    }
+
+    void* grown = realloc(array, (size_t)new_capacity * element_size);
+    if (grown) {
+        *capacity = new_capacity;
+    }
+    return grown;
 }
 
 // -- HELPERS --
 
 // -- INTERNAL FUNCTIONS --
 
-static u8 internal_add_component(entity_id entity, entity_components components) {
-    for (u32 i = 0; i < registry.entity_count; i++) {
-        if (registry.entities[i].id == entity) {
-            registry.entities[i].components |= components;
+static u32 internal_layout_archetype(archetype* arch, u32 capacity) {
+    u32 offset = sizeof(entity_id) * capacity;
 
-            if (components & ENTITY_COMPONENT_TRANSFORM) {
-                registry.transforms[i] = (transform_component){ 0 };
-            }
-            if (components & ENTITY_COMPONENT_SCRIPT) {
-                registry.scripts[i] = (script_component){ 0 }; // default null funcs
+    for (u32 c = 0; c < ECS_COMPONENT_COUNT; c++) {
+        if ((arch->mask & (1 << c)) && component_sizes[c] > 0) {
+            offset = align_up(offset, ECS_COLUMN_ALIGNMENT);
+            arch->column_offsets[c] = offset;
+            offset += component_sizes[c] * capacity;
+        }
+    }
+
+    return offset; // Total bytes used by a chunk of this capacity
+}
+
+static u8 internal_query_matches(const ecs_query* query, entity_components mask) {
+    return (mask & query->with) == query->with && (mask & query->without) == 0;
+}
+
+static archetype* internal_get_archetype(entity_components mask) {
+    archetype* arch = &registry.archetypes[mask];
+    if (arch->chunk_capacity != 0) {
+        return arch;
+    }
+
+    arch->mask = mask;
+
+    u32 row_size = sizeof(entity_id);
+    for (u32 c = 0; c < ECS_COMPONENT_COUNT; c++) {
+        if (mask & (1 << c)) {
+            row_size += component_sizes[c];
+        }
+    }
+
+    // Start from the ideal capacity and back off until the aligned columns fit in a chunk
+    u32 capacity = ECS_CHUNK_SIZE / row_size;
+    while (internal_layout_archetype(arch, capacity) > ECS_CHUNK_SIZE) {
+        capacity--;
+    }
+    arch->chunk_capacity = capacity;
+
+    registry.archetype_masks[registry.archetype_count++] = mask;
+
+    for (ecs_query* query = registry.queries; query; query = query->next) {
+        if (internal_query_matches(query, mask)) {
+            query->archetype_masks[query->archetype_count++] = mask;
+        }
+    }
+
+    return arch;
+}
+
+static entity_id* internal_row_id(const archetype* arch, u32 row) {
+    return (entity_id*)arch->chunks[row / arch->chunk_capacity] + (row % arch->chunk_capacity);
+}
+
+static void* internal_row_component(const archetype* arch, u32 row, u32 c) {
+    u8* chunk = arch->chunks[row / arch->chunk_capacity];
+    return chunk + arch->column_offsets[c] + (row % arch->chunk_capacity) * component_sizes[c];
+}
+
+// False if a new chunk is needed and can't be allocated, the archetype is then left as it was
+static u8 internal_archetype_push(archetype* arch, entity_id entity, u32* out_row) {
+    u32 row = arch->entity_count;
+
+    if (row == arch->chunk_count * arch->chunk_capacity) {
+        u8** chunks = (u8**)internal_grow(arch->chunks, &arch->chunk_reserved, arch->chunk_count + 1, sizeof(u8*));
+        if (!chunks) return false;
+        arch->chunks = chunks;
+
+        u8* chunk = (u8*)malloc(ECS_CHUNK_SIZE);
+        if (!chunk) return false;
+        arch->chunks[arch->chunk_count++] = chunk;
+    }
+
+    *internal_row_id(arch, row) = entity;
+    arch->entity_count++;
+
+    *out_row = row;
+    return true;
+}
+
+// Swap-removes a row, the last row of the archetype is moved into the hole
+static void internal_archetype_remove(archetype* arch, u32 row) {
+    u32 last = arch->entity_count - 1;
+
+    if (row != last) {
+        entity_id moved = *internal_row_id(arch, last);
+        *internal_row_id(arch, row) = moved;
+
+        for (u32 c = 0; c < ECS_COMPONENT_COUNT; c++) {
+            if ((arch->mask & (1 << c)) && component_sizes[c] > 0) {
+                memcpy(internal_row_component(arch, row, c), internal_row_component(arch, last, c), component_sizes[c]);
             }
+        }
+
+        internal_slot_at(entity_id_slot(moved))->row = row;
+    }
+
+    arch->entity_count--;
+}
+
+// Moves an entity to the archetype for new_mask, keeping the components both archetypes share
+// and zero initializing the ones that were added. False if out of memory, the entity then stays where it was.
+static u8 internal_move_entity(entity_id entity, entity_slot* slot, entity_components new_mask) {
+    archetype* src = &registry.archetypes[slot->archetype];
+    archetype* dst = internal_get_archetype(new_mask);
+
+    u32 row;
+    if (!internal_archetype_push(dst, entity, &row)) return false;
 
-            return true;
+    for (u32 c = 0; c < ECS_COMPONENT_COUNT; c++) {
+        if (!(new_mask & (1 << c)) || component_sizes[c] == 0) continue;
+
+        if (src->mask & (1 << c)) {
+            memcpy(internal_row_component(dst, row, c), internal_row_component(src, slot->row, c), component_sizes[c]);
+        }
+        else {
+            memset(internal_row_component(dst, row, c), 0, component_sizes[c]);
         }
     }
-    return false;
+
+    internal_archetype_remove(src, slot->row);
+
+    slot->archetype = new_mask;
+    slot->row = row;
+    return true;
 }
 
-static void internal_add_transform(entity_id entity, f32 x, f32 y, f32 z, f32 rotation) {
-    for (uint32_t i = 0; i < registry.entity_count; i++) {
-        if (registry.entities[i].id == entity) {
-            internal_add_component(entity, ENTITY_COMPONENT_TRANSFORM);
-            registry.transforms[i].x = x;
-            registry.transforms[i].y = y;
-            registry.transforms[i].z = z;
-            registry.transforms[i].rotation = rotation;
-            break;
+static u8 internal_reserve_slot(u32* out_slot) {
+    u8 reserved = true;
+    mutex_lock(&registry.slot_lock);
+
+    // Reuse a released slot if there is one, its generation was already bumped on destroy
+    if (registry.free_slot_count > 0) {
+        *out_slot = registry.free_slots[--registry.free_slot_count];
+    }
+    else {
+        u32 page = registry.slot_count / ECS_SLOT_PAGE_SIZE;
+
+        if (page >= ECS_SLOT_PAGE_COUNT) {
+            reserved = false; // Out of id space
+        }
+        else if (!registry.slot_pages[page]) {
+            registry.slot_pages[page] = (entity_slot*)malloc(sizeof(entity_slot) * ECS_SLOT_PAGE_SIZE);
+            reserved = registry.slot_pages[page] != NULL;
         }
+
+        if (reserved) {
+            *out_slot = registry.slot_count++;
+            internal_slot_at(*out_slot)->generation = 1; // Generation 0 is reserved so ENTITY_NULL is never valid
+        }
+    }
+
+    if (reserved) {
+        internal_slot_at(*out_slot)->row = ECS_ROW_PENDING;
     }
+
+    mutex_unlock(&registry.slot_lock);
+    return reserved;
 }
 
-static void internal_add_script(entity_id entity, on_create_fn create, on_update_fn update, on_destroy_fn destroy) {
-    for (u32 i = 0; i < registry.entity_count; i++) {
-        if (registry.entities[i].id == entity) {
-            internal_add_component(entity, ENTITY_COMPONENT_SCRIPT);
-            registry.scripts[i].on_create = create;
-            registry.scripts[i].on_update = update;
-            registry.scripts[i].on_destroy = destroy;
-            break;
+static void internal_release_slot(u32 slot) {
+    mutex_lock(&registry.slot_lock);
+
+    // Invalidate every outstanding copy of the id
+    entity_slot* entry = internal_slot_at(slot);
+    if (++entry->generation == 0) {
+        entry->generation = 1;
+    }
+    entry->row = ECS_ROW_PENDING;
+
+    // The free list only counts room it actually got. Out of memory the slot is never handed out again,
+    // its bumped generation keeps old ids invalid.
+    u32* free_slots = (u32*)internal_grow(registry.free_slots, &registry.free_slot_capacity, registry.free_slot_count + 1, sizeof(u32));
+    if (free_slots) {
+        registry.free_slots = free_slots;
+        registry.free_slots[registry.free_slot_count++] = slot;
+    }
+
+    mutex_unlock(&registry.slot_lock);
+}
+
+// Places a reserved entity straight into the archetype for mask, all components zeroed.
+// False if out of memory, the slot is then still reserved and the caller releases it.
+static u8 internal_place_entity(entity_id entity, entity_components mask) {
+    entity_slot* slot = internal_slot_at(entity_id_slot(entity));
+    archetype* arch = internal_get_archetype(mask);
+
+    u32 row;
+    if (!internal_archetype_push(arch, entity, &row)) return false;
+
+    slot->archetype = mask;
+    slot->row = row;
+    registry.entity_count++;
+
+    for (u32 c = 0; c < ECS_COMPONENT_COUNT; c++) {
+        if ((mask & (1 << c)) && component_sizes[c] > 0) {
+            memset(internal_row_component(arch, slot->row, c), 0, component_sizes[c]);
         }
     }
+
+    return true;
 }
 
-static void internal_add_custom(entity_id entity, const u8* data) {
-    for (uint32_t i = 0; i < registry.entity_count; i++) {
-        if (registry.entities[i].id == entity) {
-            internal_add_component(entity, ENTITY_COMPONENT_CUSTOM);
-            memcpy(&registry.custom_components[i].data[0], data, sizeof(custom_component));
-            break;
+static void internal_add_component(entity_id entity, const void* component_data, entity_components component) {
+    entity_slot* slot = internal_get_slot(entity);
+    if (!slot) return;
+
+    if (!(slot->archetype & component) && !internal_move_entity(entity, slot, slot->archetype | component)) {
+        return; // Out of memory, the component is dropped
+    }
+
+    u32 c = component_index(component);
+    if (c < ECS_COMPONENT_COUNT && component_sizes[c] > 0) {
+        memcpy(internal_row_component(&registry.archetypes[slot->archetype], slot->row, c), component_data, component_sizes[c]);
+    }
+}
+
+static void internal_remove_component(entity_id entity, entity_components component) {
+    entity_slot* slot = internal_get_slot(entity);
+    if (!slot || !(slot->archetype & component)) return;
+
+    internal_move_entity(entity, slot, slot->archetype & ~component);
+}
+
+static int internal_compare_destroys(const void* a, const void* b) {
+    const pending_destroy* da = (const pending_destroy*)a;
+    const pending_destroy* db = (const pending_destroy*)b;
+
+    if (da->archetype != db->archetype) return da->archetype < db->archetype ? -1 : 1;
+    if (da->row != db->row) return da->row > db->row ? -1 : 1; // Highest rows first
+    return 0;
+}
+
+// Destroys a batch of entities. They are sorted by archetype and by descending row, so every
+// swap-remove pulls in a survivor from the tail and each table is compacted in a single pass.
+static void internal_destroy_entities(const entity_id* entities, u32 count) {
+    if (count == 0) return;
+
+    pending_destroy* scratch = (pending_destroy*)internal_grow(registry.destroy_scratch, &registry.destroy_scratch_capacity, count, sizeof(pending_destroy));
+    if (!scratch) {
+        // Out of memory, destroy them in batches the scratch already has room for
+        u32 batch = registry.destroy_scratch_capacity;
+        for (u32 i = 0; batch > 0 && i < count; i += batch) {
+            internal_destroy_entities(entities + i, count - i < batch ? count - i : batch);
+        }
+        return;
+    }
+    registry.destroy_scratch = scratch;
+
+    u32 pending_count = 0;
+    for (u32 i = 0; i < count; i++) {
+        entity_slot* slot = internal_get_slot(entities[i]);
+        if (!slot) continue; // Already dead or stale
+
+        registry.destroy_scratch[pending_count++] = (pending_destroy){ slot->archetype, slot->row, entities[i] };
+    }
+
+    qsort(registry.destroy_scratch, pending_count, sizeof(pending_destroy), internal_compare_destroys);
+
+    // Drop duplicates, they are adjacent after sorting
+    u32 unique_count = 0;
+    for (u32 i = 0; i < pending_count; i++) {
+        if (unique_count == 0 || registry.destroy_scratch[unique_count - 1].entity != registry.destroy_scratch[i].entity) {
+            registry.destroy_scratch[unique_count++] = registry.destroy_scratch[i];
+        }
+    }
+
+    // Run the destroy callbacks first. Anything they change structurally is deferred,
+    // which keeps the archetype rows gathered above valid until the batch is removed.
+    u32 script_index = component_index(ENTITY_COMPONENT_SCRIPT);
+    registry.defer_depth++;
+    for (u32 i = 0; i < unique_count; i++) {
+        const pending_destroy* d = &registry.destroy_scratch[i];
+        if (!(d->archetype & ENTITY_COMPONENT_SCRIPT)) continue;
+
+        const script_component* s = (const script_component*)internal_row_component(&registry.archetypes[d->archetype], d->row, script_index);
+        if (s->on_destroy) {
+            s->on_destroy(d->entity);
         }
     }
+    registry.defer_depth--;
+
+    for (u32 i = 0; i < unique_count; i++) {
+        const pending_destroy* d = &registry.destroy_scratch[i];
+
+        internal_archetype_remove(&registry.archetypes[d->archetype], d->row);
+        internal_release_slot(entity_id_slot(d->entity));
+        registry.entity_count--;
+    }
 }
 
-static void internal_add_sprite(entity_id entity, const sprite_component* sprite) {
-    for (uint32_t i = 0; i < registry.entity_count; i++) {
-        if (registry.entities[i].id == entity) {
-            internal_add_component(entity, ENTITY_COMPONENT_SPRITE);
-            memcpy(&registry.sprite_components[i], sprite, sizeof(sprite_component));
-            break;
+static void internal_apply_commands(ecs_command_buffer* cb) {
+    for (u32 i = 0; i < cb->command_count; i++) {
+        const ecs_command* cmd = &cb->commands[i];
+
+        switch (cmd->type) {
+            case ECS_COMMAND_CREATE: {
+                // Fold the adds that directly follow the create into it, so the new entity is
+                // placed in its final archetype instead of moving once per component
+                entity_components mask = 0;
+                u32 last = i;
+                while (last + 1 < cb->command_count &&
+                       cb->commands[last + 1].type == ECS_COMMAND_ADD_COMPONENT &&
+                       cb->commands[last + 1].entity == cmd->entity) {
+                    mask |= cb->commands[++last].component;
+                }
+
+                if (!internal_place_entity(cmd->entity, mask)) {
+                    // Out of memory, the id goes stale so the later commands that use it do nothing
+                    internal_release_slot(entity_id_slot(cmd->entity));
+                    i = last;
+                    break;
+                }
+
+                for (u32 j = i + 1; j <= last; j++) {
+                    internal_add_component(cmd->entity, cb->data + cb->commands[j].data_offset, cb->commands[j].component);
+                }
+
+                i = last;
+                break;
+            }
+            case ECS_COMMAND_ADD_COMPONENT: {
+                internal_add_component(cmd->entity, cb->data + cmd->data_offset, cmd->component);
+                break;
+            }
+            case ECS_COMMAND_REMOVE_COMPONENT: {
+                internal_remove_component(cmd->entity, cmd->component);
+                break;
+            }
         }
     }
+
+    internal_destroy_entities(cb->destroys, cb->destroy_count);
+
+    cb->command_count = 0;
+    cb->data_size = 0;
+    cb->destroy_count = 0;
+}
+
+// Plays back everything recorded while iterating, including changes made by destroy callbacks
+static void internal_flush_deferred() {
+    while (registry.deferred->command_count > 0 || registry.deferred->destroy_count > 0) {
+        ecs_command_buffer* cb = registry.deferred;
+        registry.deferred = registry.deferred_spare;
+        registry.deferred_spare = cb;
+
+        internal_apply_commands(cb);
+    }
+}
+
+static void internal_begin_defer() {
+    registry.defer_depth++;
+}
+
+static void internal_end_defer() {
+    if (--registry.defer_depth == 0) {
+        internal_flush_deferred();
+    }
+}
+
+// Sprite sort key, compared as one integer:
+//   bits 63..32  depth, ascending so transparent sprites blend back to front
+//   bits 31..28  blend mode (sprites only use alpha blending for now)
+//   bits 27..8   texture page then layer, sprites sharing a page at the same depth end up in the same batch
+//   bits  7..0   material (unused)
+static u64 internal_sprite_sort_key(const transform_component* t, const sprite_component* s) {
+    u32 texture = texture_array_sort_key(s->is_animated ? s->sprite.atlas.texture_id : s->texture_id) & 0xFFFFF;
+    u32 blend = 0;
+    u32 material = 0;
+
+    return ((u64)radix_sort_float_key(t->z) << 32) | ((u64)blend << 28) | ((u64)texture << 8) | material;
+}
+
+// False for an animated sprite without a valid frame, which isn't drawn
+static u8 internal_sprite_instance(const transform_component* t, const sprite_component* s, sprite_instance* out) {
+    out->x = t->x;
+    out->y = t->y;
+    out->width = s->width == 0 ? (f32)s->sprite.atlas.sprite_width : (f32)s->width;
+    out->height = s->height == 0 ? (f32)s->sprite.atlas.sprite_height : (f32)s->height;
+    out->rotation = degrees_to_radians(t->rotation);
+    out->z = t->z;
+    out->color = (color4){ 1.0f, 1.0f, 1.0f, 1.0f };
+
+    if (s->is_animated) {
+        const animation_state* state = &s->sprite.anim_state;
+        if (!state->animation) return false;
+
+        i32 frame = state->animation->frames[state->current_frame].frame_index;
+        if (frame < 0 || frame >= s->sprite.atlas.sprite_count) return false;
+
+        out->texture = s->sprite.atlas.texture_id;
+        out->rect = s->sprite.atlas.uvs[frame];
+    }
+    else {
+        out->texture = s->texture_id;
+        out->rect = (uv_rect){ 0.0f, 0.0f, 1.0f, 1.0f };
+    }
+
+    return true;
+}
+
+static void internal_draw_sprite(const transform_component* t, const sprite_component* s) {
+    sprite_instance instance;
+    if (internal_sprite_instance(t, s, &instance)) {
+        renderer2D_draw_rotated_quad_atlas(instance.x, instance.y, instance.width, instance.height, instance.texture,
+                                           &instance.rect, instance.color, instance.rotation, instance.z);
+    }
+}
+
+// Puts a static sprite at index of the retained batch, false if it has to be drawn like any other sprite
+static u8 internal_set_static_sprite(u32 index, const transform_component* t, const sprite_component* s) {
+    if (!registry.static_sprites) {
+        registry.static_sprites = renderer2D_static_batch_create(ECS_STATIC_SPRITE_CAPACITY);
+        if (!registry.static_sprites) return false;
+    }
+
+    sprite_instance instance;
+    if (!internal_sprite_instance(t, s, &instance)) {
+        instance.width = 0.0f; // Keeps the index of the sprites after it, a zero sized quad covers nothing
+        instance.height = 0.0f;
+        instance.texture = -1;
+        instance.rect = (uv_rect){ 0.0f, 0.0f, 1.0f, 1.0f };
+    }
+
+    return renderer2D_static_batch_set(registry.static_sprites, index, &instance);
+}
+
+static u8 internal_reserve_sprite_scratch(u32 count) {
+    if (count <= registry.sprite_capacity) return true;
+
+    u32 capacity = registry.sprite_capacity ? registry.sprite_capacity : 256;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+
+    sprite_draw* draws = (sprite_draw*)realloc(registry.sprite_draws, sizeof(sprite_draw) * capacity);
+    if (draws) registry.sprite_draws = draws;
+    u64* keys = (u64*)realloc(registry.sprite_keys, sizeof(u64) * capacity);
+    if (keys) registry.sprite_keys = keys;
+    u64* temp_keys = (u64*)realloc(registry.sprite_temp_keys, sizeof(u64) * capacity);
+    if (temp_keys) registry.sprite_temp_keys = temp_keys;
+    u32* order = (u32*)realloc(registry.sprite_order, sizeof(u32) * capacity);
+    if (order) registry.sprite_order = order;
+    u32* temp_order = (u32*)realloc(registry.sprite_temp_order, sizeof(u32) * capacity);
+    if (temp_order) registry.sprite_temp_order = temp_order;
+
+    if (!draws || !keys || !temp_keys || !order || !temp_order) return false;
+
+    registry.sprite_capacity = capacity;
+    return true;
 }
 
 // -- INTERNAL FUNCTIONS --
@@ -126,230 +652,458 @@ static void internal_add_sprite(entity_id entity, const sprite_component* sprite
 // -- ENTITY COMPONENT SYSTEM FUNCTIONS --
 
 void ecs_init() {
-	registry.entities = (entity_record*)malloc(sizeof(entity_record) * MAX_ENTITIES);
-    registry.transforms = (transform_component*)malloc(sizeof(transform_component) * MAX_ENTITIES);
-    registry.scripts = (script_component*)malloc(sizeof(script_component) * MAX_ENTITIES);
-    registry.custom_components = malloc(sizeof(custom_component) * MAX_ENTITIES);
-    registry.sprite_components = malloc(sizeof(sprite_component) * MAX_ENTITIES);
+    memset(&registry, 0, sizeof(entity_registry));
+
+    mutex_create(&registry.slot_lock);
 
-    memset(registry.entities, 0, sizeof(entity_record) * MAX_ENTITIES);
-    memset(registry.transforms, 0, sizeof(transform_component) * MAX_ENTITIES);
-    memset(registry.scripts, 0, sizeof(script_component) * MAX_ENTITIES);
-    memset(registry.custom_components, 0, sizeof(custom_component) * MAX_ENTITIES);
-    memset(registry.sprite_components, 0, sizeof(sprite_component) * MAX_ENTITIES);
+    internal_get_archetype(0); // Freshly created entities live in the empty archetype
 
-    srand((u32)time(NULL));
+    registry.deferred = ecs_command_buffer_create();
+    registry.deferred_spare = ecs_command_buffer_create();
+
+    registry.script_query = ecs_query_create(ENTITY_COMPONENT_SCRIPT, 0);
+    registry.sprite_query = ecs_query_create(ENTITY_COMPONENT_SPRITE, 0);
 }
 
 void ecs_shutdown() {
-    if (registry.sprite_components) {
-        free(registry.sprite_components);
+    while (registry.queries) {
+        ecs_query_destroy(registry.queries);
+    }
+
+    ecs_command_buffer_destroy(registry.deferred);
+    ecs_command_buffer_destroy(registry.deferred_spare);
+    registry.deferred = NULL;
+    registry.deferred_spare = NULL;
+
+    renderer2D_static_batch_destroy(registry.static_sprites);
+    registry.static_sprites = NULL;
+
+    if (registry.destroy_scratch) {
+        free(registry.destroy_scratch);
     }
 
-    if (registry.custom_components) {
-        free(registry.custom_components);
+    free(registry.sprite_draws);
+    free(registry.sprite_keys);
+    free(registry.sprite_temp_keys);
+    free(registry.sprite_order);
+    free(registry.sprite_temp_order);
+
+    for (u32 i = 0; i < registry.archetype_count; i++) {
+        archetype* arch = &registry.archetypes[registry.archetype_masks[i]];
+
+        for (u32 chunk = 0; chunk < arch->chunk_count; chunk++) {
+            free(arch->chunks[chunk]);
+        }
+
+        if (arch->chunks) {
+            free(arch->chunks);
+        }
     }
 
-    if (registry.scripts) {
-        free(registry.scripts);
+    if (registry.free_slots) {
+        free(registry.free_slots);
     }
 
-    if (registry.transforms) {
-        free(registry.transforms);
+    for (u32 page = 0; page < ECS_SLOT_PAGE_COUNT && registry.slot_pages[page]; page++) {
+        free(registry.slot_pages[page]);
     }
 
-	if (registry.entities) {
-		free(registry.entities);
-	}
+    mutex_destroy(&registry.slot_lock);
+    memset(&registry, 0, sizeof(entity_registry));
 }
 
 void ecs_for_each(entity_components filter, ecs_entity_iter_fn fn) {
-    for (u32 i = 0; i < registry.entity_count; i++) {
-        if ((registry.entities[i].components & filter) == filter) {
-            fn(registry.entities[i].id, i);
+    // Structural changes made by the callback are deferred until the loop is done
+    internal_begin_defer();
+
+    for (u32 a = 0; a < registry.archetype_count; a++) {
+        archetype* arch = &registry.archetypes[registry.archetype_masks[a]];
+        if ((arch->mask & filter) != filter) continue;
+
+        for (u32 row = 0; row < arch->entity_count; row++) {
+            fn(*internal_row_id(arch, row), row);
         }
     }
+
+    internal_end_defer();
 }
 
-void ecs_initialize_scripts() {
-    for (u32 i = 0; i < registry.entity_count; i++) {
-        if (registry.entities[i].components & ENTITY_COMPONENT_SCRIPT) {
-            if (registry.scripts[i].on_create) {
-                registry.scripts[i].on_create(registry.entities[i].id);
+typedef enum {
+    SCRIPT_CALLBACK_CREATE,
+    SCRIPT_CALLBACK_UPDATE,
+    SCRIPT_CALLBACK_DESTROY
+} script_callback;
+
+static void internal_run_scripts(script_callback callback, f32 delta_time) {
+    u32 c = component_index(ENTITY_COMPONENT_SCRIPT);
+    const ecs_query* query = registry.script_query;
+
+    // Scripts may create, destroy and change entities, those changes are recorded and
+    // played back once every script has run so no entity is skipped or visited twice
+    internal_begin_defer();
+
+    for (u32 a = 0; a < query->archetype_count; a++) {
+        archetype* arch = &registry.archetypes[query->archetype_masks[a]];
+
+        for (u32 row = 0; row < arch->entity_count; row++) {
+            entity_id id = *internal_row_id(arch, row);
+            const script_component* s = (const script_component*)internal_row_component(arch, row, c);
+
+            switch (callback) {
+                case SCRIPT_CALLBACK_CREATE: if (s->on_create) s->on_create(id); break;
+                case SCRIPT_CALLBACK_UPDATE: if (s->on_update) s->on_update(id, delta_time); break;
+                case SCRIPT_CALLBACK_DESTROY: if (s->on_destroy) s->on_destroy(id); break;
             }
         }
     }
+
+    internal_end_defer();
+}
+
+void ecs_initialize_scripts() {
+    internal_run_scripts(SCRIPT_CALLBACK_CREATE, 0.0f);
 }
 
 void ecs_update_scripts(f32 delta_time) {
-    for (u32 i = 0; i < registry.entity_count; i++) {
-        if (registry.entities[i].components & ENTITY_COMPONENT_SCRIPT) {
-            if (registry.scripts[i].on_update) {
-                registry.scripts[i].on_update(registry.entities[i].id, delta_time);
-            }
-        }
-    }
+    internal_run_scripts(SCRIPT_CALLBACK_UPDATE, delta_time);
 }
 
 void ecs_shutdown_scripts() {
-    for (u32 i = 0; i < registry.entity_count; i++) {
-        if (registry.entities[i].components & ENTITY_COMPONENT_SCRIPT) {
-            if (registry.scripts[i].on_destroy) {
-                registry.scripts[i].on_destroy(registry.entities[i].id);
-            }
+    internal_run_scripts(SCRIPT_CALLBACK_DESTROY, 0.0f);
+}
+
+void ecs_update_sprite_animations_span(const ecs_query_iter* it, f32 delta_time) {
+    sprite_component* sprites = ecs_iter_sprites(it);
+
+    for (u32 i = 0; i < it->count; i++) {
+        if (sprites[i].is_animated) {
+            animation_state_update(&sprites[i].sprite.anim_state, delta_time);
         }
     }
 }
 
 void ecs_update_sprite_animations(f32 delta_time) {
-    for (u32 i = 0; i < registry.entity_count; i++) {
-        if (registry.entities[i].components & ENTITY_COMPONENT_SPRITE) {
-            sprite_component* s = &registry.sprite_components[i];
+    ecs_query_iter it = ecs_query_iter_begin(registry.sprite_query);
 
-            if (s->is_animated) {
-                animation_state_update(&s->sprite.anim_state, delta_time);
-            }
-        }
+    while (ecs_query_iter_next(&it)) {
+        ecs_update_sprite_animations_span(&it, delta_time);
+    }
+}
+
+void ecs_draw_sprites_span(const ecs_query_iter* it) {
+    const transform_component identity = { 0 };
+    const transform_component* transforms = ecs_iter_transforms(it);
+    const sprite_component* sprites = ecs_iter_sprites(it);
+
+    for (u32 i = 0; i < it->count; i++) {
+        internal_draw_sprite(transforms ? &transforms[i] : &identity, &sprites[i]);
     }
 }
 
 void ecs_draw_sprites() {
-    for (u32 i = 0; i < registry.entity_count; i++) {
-        if (registry.entities[i].components & ENTITY_COMPONENT_SPRITE) {
-            const transform_component* t = &registry.transforms[i];
-            const sprite_component* s = &registry.sprite_components[i];
-
-            if (s->is_animated) {
-                renderer2D_draw_animated_sprite(t->x, t->y, s->width == 0 ? (f32)s->sprite.atlas.sprite_width : (f32)s->width,
-                                                            s->height == 0 ? (f32)s->sprite.atlas.sprite_height : (f32)s->height,
-                                                            &s->sprite, (color4) { 1.0f, 1.0f, 1.0f, 1.0f }, degrees_to_radians(t->rotation), t->z);
-            }
-            else {
-                renderer2D_draw_rotated_quad(t->x, t->y, s->width == 0 ? (f32)s->sprite.atlas.sprite_width : (f32)s->width,
-                                                         s->height == 0 ? (f32)s->sprite.atlas.sprite_height : (f32)s->height,
-                                                         s->texture_id, (color4) { 1.0f, 1.0f, 1.0f, 1.0f }, degrees_to_radians(t->rotation), t->z);
+    const transform_component identity = { 0 };
+    u32 count = ecs_query_count(registry.sprite_query);
+    if (count == 0 || !internal_reserve_sprite_scratch(count)) return;
+
+    // Gather every sprite with its sort key, the index into sprite_draws rides along with the key.
+    // Static sprites go to the retained batch instead, where only the ones that changed are written again.
+    u32 gathered = 0;
+    u32 static_count = 0;
+    ecs_query_iter it = ecs_query_iter_begin(registry.sprite_query);
+    while (ecs_query_iter_next(&it)) {
+        const transform_component* transforms = ecs_iter_transforms(&it);
+        const sprite_component* sprites = ecs_iter_sprites(&it);
+
+        for (u32 i = 0; i < it.count; i++) {
+            const transform_component* transform = transforms ? &transforms[i] : &identity;
+            if (sprites[i].is_static && internal_set_static_sprite(static_count, transform, &sprites[i])) {
+                static_count++;
+                continue;
             }
+
+            sprite_draw* draw = &registry.sprite_draws[gathered];
+            draw->transform = transform;
+            draw->sprite = &sprites[i];
+
+            registry.sprite_keys[gathered] = internal_sprite_sort_key(draw->transform, draw->sprite);
+            registry.sprite_order[gathered] = gathered;
+            gathered++;
         }
     }
+
+    if (registry.static_sprites) {
+        renderer2D_static_batch_truncate(registry.static_sprites, static_count);
+        renderer2D_draw_static_batch(registry.static_sprites);
+    }
+
+    radix_sort_u64(registry.sprite_keys, registry.sprite_order, registry.sprite_temp_keys, registry.sprite_temp_order, gathered);
+
+    for (u32 i = 0; i < gathered; i++) {
+        const sprite_draw* draw = &registry.sprite_draws[registry.sprite_order[i]];
+        internal_draw_sprite(draw->transform, draw->sprite);
+    }
 }
 
 // -- ENTITY COMPONENT SYSTEM FUNCTIONS --
 
-// -- ENTITY FUNCTIONS --
+// -- QUERY FUNCTIONS --
 
-entity_id entity_create() {
-    if (registry.entity_count >= MAX_ENTITIES) return 0; // no more room
+ecs_query* ecs_query_create(entity_components with, entity_components without) {
+    ecs_query* query = (ecs_query*)calloc(1, sizeof(ecs_query));
+    if (!query) return NULL;
 
-    entity_id id = generate_uuid();
+    query->with = with;
+    query->without = without;
 
-    entity_record* rec = &registry.entities[registry.entity_count++];
-    rec->id = id;
-    rec->components = 0;
+    // Match the archetypes that already exist, new ones are appended as they get created
+    for (u32 a = 0; a < registry.archetype_count; a++) {
+        if (internal_query_matches(query, registry.archetype_masks[a])) {
+            query->archetype_masks[query->archetype_count++] = registry.archetype_masks[a];
+        }
+    }
 
-    return id;
+    query->next = registry.queries;
+    registry.queries = query;
+
+    return query;
 }
 
-void entity_add_component(entity_id entity, const void* component_data, entity_components component) {
-    switch (component) {
-        case ENTITY_COMPONENT_TRANSFORM: {
-            const transform_component* transform = (const transform_component*)component_data;
-            internal_add_transform(entity, transform->x, transform->y, transform->z, transform->rotation);
-            break;
-        }
-        case ENTITY_COMPONENT_SCRIPT: {
-            const script_component* script = (const script_component*)component_data;
-            internal_add_script(entity, script->on_create, script->on_update, script->on_destroy);
-            break;
-        }
-        case ENTITY_COMPONENT_CUSTOM: {
-            const custom_component* custom = (const custom_component*)component_data;
-            internal_add_custom(entity, &custom->data[0]);
-            break;
-        }
-        case ENTITY_COMPONENT_SPRITE: {
-            const sprite_component* sprite = (const sprite_component*)component_data;
-            internal_add_sprite(entity, sprite);
+void ecs_query_destroy(ecs_query* query) {
+    if (!query) return;
+
+    for (ecs_query** link = &registry.queries; *link; link = &(*link)->next) {
+        if (*link == query) {
+            *link = query->next;
             break;
         }
     }
+
+    free(query);
 }
 
-u8 entity_has_component(entity_id entity, entity_components components) {
-    for (u32  i = 0; i < registry.entity_count; i++) {
-        if (registry.entities[i].id == entity) {
-            return (registry.entities[i].components & components) != 0;
+u32 ecs_query_count(const ecs_query* query) {
+    u32 count = 0;
+    for (u32 a = 0; a < query->archetype_count; a++) {
+        count += registry.archetypes[query->archetype_masks[a]].entity_count;
+    }
+    return count;
+}
+
+ecs_query_iter ecs_query_iter_begin(const ecs_query* query) {
+    ecs_query_iter it = { 0 };
+    it.query = query;
+    return it;
+}
+
+u8 ecs_query_iter_next(ecs_query_iter* it) {
+    const ecs_query* query = it->query;
+
+    for (; it->archetype_cursor < query->archetype_count; it->archetype_cursor++, it->chunk_cursor = 0) {
+        const archetype* arch = &registry.archetypes[query->archetype_masks[it->archetype_cursor]];
+
+        u32 first_row = it->chunk_cursor * arch->chunk_capacity;
+        if (first_row >= arch->entity_count) continue;
+
+        u8* chunk = arch->chunks[it->chunk_cursor++];
+
+        it->count = arch->entity_count - first_row;
+        if (it->count > arch->chunk_capacity) it->count = arch->chunk_capacity;
+
+        it->entities = (entity_id*)chunk;
+        for (u32 c = 0; c < ECS_COMPONENT_COUNT; c++) {
+            u8 has_column = (arch->mask & (1 << c)) && component_sizes[c] > 0;
+            it->columns[c] = has_column ? chunk + arch->column_offsets[c] : NULL;
         }
+
+        return true;
     }
+
+    it->count = 0;
     return false;
 }
 
-void entity_remove_component(entity_id entity, entity_components component) {
-    for (u32 i = 0; i < registry.entity_count; i++) {
-        if (registry.entities[i].id == entity) {
-            registry.entities[i].components &= ~component;
+void* _ecs_query_iter_column(const ecs_query_iter* it, entity_components component) {
+    u32 c = component_index(component);
+    return c < ECS_COMPONENT_COUNT ? it->columns[c] : NULL;
+}
 
-            if (component & ENTITY_COMPONENT_TRANSFORM) {
-                registry.transforms[i] = (transform_component){ 0 }; // Reset data
-            }
-            if (component & ENTITY_COMPONENT_SCRIPT) {
-                registry.scripts[i] = (script_component){ 0 };
-            }
-            if (component & ENTITY_COMPONENT_CUSTOM) {
-                registry.custom_components[i] = (custom_component){ 0 };
-            }
-            if (component & ENTITY_COMPONENT_SPRITE) {
-                registry.sprite_components[i] = (sprite_component){ 0 };
-            }
-            break;
-        }
+// -- QUERY FUNCTIONS --
+
+// -- ENTITY FUNCTIONS --
+
+entity_id entity_create() {
+    if (registry.defer_depth > 0) {
+        return ecs_command_buffer_create_entity(registry.deferred);
+    }
+
+    u32 slot;
+    if (!internal_reserve_slot(&slot)) return ENTITY_NULL;
+
+    entity_id id = entity_id_make(slot, internal_slot_at(slot)->generation);
+    if (!internal_place_entity(id, 0)) {
+        internal_release_slot(slot);
+        return ENTITY_NULL;
     }
+
+    return id;
 }
 
-void entity_destroy(entity_id entity) {
-    for (u32 i = 0; i < registry.entity_count; i++) {
-        if (registry.entities[i].id == entity) {
-            u32 last = registry.entity_count - 1;
+void entity_add_component(entity_id entity, const void* component_data, entity_components component) {
+    if (registry.defer_depth > 0) {
+        ecs_command_buffer_add_component(registry.deferred, entity, component_data, component);
+        return;
+    }
 
-            // Move last entity into current slot
-            registry.entities[i] = registry.entities[last];
-            registry.transforms[i] = registry.transforms[last];
+    internal_add_component(entity, component_data, component);
+}
 
-            if (registry.scripts[i].on_destroy) {
-                registry.scripts[i].on_destroy(entity);
-            }
+u8 entity_has_component(entity_id entity, entity_components components) {
+    entity_slot* slot = internal_get_slot(entity);
+    if (!slot) return false;
 
-            registry.scripts[i] = registry.scripts[last];
-            registry.custom_components[i] = registry.custom_components[last];
-            registry.sprite_components[i] = registry.sprite_components[last];
+    return (slot->archetype & components) != 0;
+}
 
-            registry.entity_count--;
-            return;
-        }
+u8 entity_is_alive(entity_id entity) {
+    return internal_get_slot(entity) != NULL;
+}
+
+void entity_remove_component(entity_id entity, entity_components component) {
+    if (registry.defer_depth > 0) {
+        ecs_command_buffer_remove_component(registry.deferred, entity, component);
+        return;
     }
+
+    internal_remove_component(entity, component);
+}
+
+void entity_destroy(entity_id entity) {
+    if (registry.defer_depth > 0) {
+        ecs_command_buffer_destroy_entity(registry.deferred, entity);
+        return;
+    }
+
+    internal_destroy_entities(&entity, 1);
+    internal_flush_deferred(); // Apply whatever the destroy callback recorded
 }
 
 void* _entity_get_component(entity_id entity, entity_components component) {
-    for (u32 i = 0; i < registry.entity_count; i++) {
-        if (registry.entities[i].id == entity &&
-            (registry.entities[i].components & component)) {
-            switch (component) {
-                case ENTITY_COMPONENT_TRANSFORM: {
-                    return &registry.transforms[i];
-                }
-                case ENTITY_COMPONENT_SCRIPT: {
-                    return &registry.scripts[i];
-                }
-                case ENTITY_COMPONENT_CUSTOM: {
-                    return &registry.custom_components[i];
-                }
-                case ENTITY_COMPONENT_SPRITE: {
-                    return &registry.sprite_components[i];
-                }
-            }
+    entity_slot* slot = internal_get_slot(entity);
+    if (!slot || !(slot->archetype & component)) {
+        return NULL; // Not found or the entity doesn't have the component
+    }
+
+    u32 c = component_index(component);
+    if (c >= ECS_COMPONENT_COUNT || component_sizes[c] == 0) {
+        return NULL;
+    }
+
+    return internal_row_component(&registry.archetypes[slot->archetype], slot->row, c);
+}
+
+// -- ENTITY FUNCTIONS --
+
+// -- COMMAND BUFFER FUNCTIONS --
+
+// NULL if the buffer can't grow, the command is dropped
+static ecs_command* internal_push_command(ecs_command_buffer* cb, ecs_command_type type, entity_id entity, entity_components component) {
+    ecs_command* commands = (ecs_command*)internal_grow(cb->commands, &cb->command_capacity, cb->command_count + 1, sizeof(ecs_command));
+    if (!commands) return NULL;
+    cb->commands = commands;
+
+    ecs_command* cmd = &cb->commands[cb->command_count++];
+    cmd->type = type;
+    cmd->component = component;
+    cmd->entity = entity;
+    cmd->data_offset = 0;
+
+    return cmd;
+}
+
+ecs_command_buffer* ecs_command_buffer_create() {
+    return (ecs_command_buffer*)calloc(1, sizeof(ecs_command_buffer));
+}
+
+void ecs_command_buffer_destroy(ecs_command_buffer* cb) {
+    if (!cb) return;
+
+    // Ids reserved by creates that never got played back go back to the registry
+    for (u32 i = 0; i < cb->command_count; i++) {
+        if (cb->commands[i].type == ECS_COMMAND_CREATE && entity_id_slot(cb->commands[i].entity) < registry.slot_count) {
+            internal_release_slot(entity_id_slot(cb->commands[i].entity));
         }
     }
 
-    return NULL; // Not found or the entity doesn't have the component
+    if (cb->commands) {
+        free(cb->commands);
+    }
+
+    if (cb->data) {
+        free(cb->data);
+    }
+
+    if (cb->destroys) {
+        free(cb->destroys);
+    }
+
+    free(cb);
+}
+
+entity_id ecs_command_buffer_create_entity(ecs_command_buffer* cb) {
+    // The id is reserved right away so it can be used in later commands of the same buffer
+    u32 slot;
+    if (!internal_reserve_slot(&slot)) return ENTITY_NULL;
+
+    entity_id id = entity_id_make(slot, internal_slot_at(slot)->generation);
+    if (!internal_push_command(cb, ECS_COMMAND_CREATE, id, 0)) {
+        internal_release_slot(slot);
+        return ENTITY_NULL;
+    }
+
+    return id;
+}
+
+void ecs_command_buffer_destroy_entity(ecs_command_buffer* cb, entity_id entity) {
+    entity_id* destroys = (entity_id*)internal_grow(cb->destroys, &cb->destroy_capacity, cb->destroy_count + 1, sizeof(entity_id));
+    if (!destroys) return;
+
+    cb->destroys = destroys;
+    cb->destroys[cb->destroy_count++] = entity;
+}
+
+void ecs_command_buffer_add_component(ecs_command_buffer* cb, entity_id entity, const void* component_data, entity_components component) {
+    u32 c = component_index(component);
+    u32 size = c < ECS_COMPONENT_COUNT ? component_sizes[c] : 0;
+    if (size == 0) {
+        internal_push_command(cb, ECS_COMMAND_ADD_COMPONENT, entity, component);
+        return;
+    }
+
+    // Room for the data first, a command must never point at data that wasn't written
+    u32 offset = align_up(cb->data_size, ECS_COLUMN_ALIGNMENT);
+    u8* data = (u8*)internal_grow(cb->data, &cb->data_capacity, offset + size, 1);
+    if (!data) return;
+    cb->data = data;
+
+    ecs_command* cmd = internal_push_command(cb, ECS_COMMAND_ADD_COMPONENT, entity, component);
+    if (!cmd) return;
+
+    memcpy(cb->data + offset, component_data, size);
+
+    cmd->data_offset = offset;
+    cb->data_size = offset + size;
+}
+
+void ecs_command_buffer_remove_component(ecs_command_buffer* cb, entity_id entity, entity_components component) {
+    internal_push_command(cb, ECS_COMMAND_REMOVE_COMPONENT, entity, component);
+}
+
+void ecs_command_buffer_playback(ecs_command_buffer* cb) {
+    internal_apply_commands(cb);
+
+    if (registry.defer_depth == 0) {
+        internal_flush_deferred();
+    }
 }
 
-// -- ENTITY FUNCTIONS --
\ No newline at end of file
+// -- COMMAND BUFFER FUNCTIONS --
\ No newline at end of file
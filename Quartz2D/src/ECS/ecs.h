@@ -11,27 +11,71 @@ typedef enum {
 	ENTITY_COMPONENT_RIGIDBODY = (1 << 1),
 	ENTITY_COMPONENT_SPRITE = (1 << 2),
 	ENTITY_COMPONENT_SCRIPT = (1 << 3),
-	ENTITY_COMPONENT_CUSTOM = (1 << 4)
+	ENTITY_COMPONENT_CUSTOM = (1 << 4),
+	ENTITY_COMPONENT_COLLIDER = (1 << 5)
 } entity_components;
 
+#define ECS_COMPONENT_COUNT 6
+
+// index is the row of the entity inside its archetype table
 typedef void (*ecs_entity_iter_fn)(entity_id id, u32 index);
 
+// A query is created once and keeps its own list of matching archetype tables, which is
+// extended whenever a new archetype appears. Iterating it only visits matching entities.
+typedef struct ecs_query ecs_query;
+
+// One contiguous span of matching entities, columns[] holds the component arrays of the span
+// indexed by component bit position (NULL for components the span does not have)
+typedef struct {
+	const ecs_query* query;
+	u32 archetype_cursor;
+	u32 chunk_cursor;
+
+	u32 count;
+	entity_id* entities;
+	void* columns[ECS_COMPONENT_COUNT];
+} ecs_query_iter;
+
+// Records structural changes (create, destroy, add, remove) so they can be applied later in one
+// batch at a sync point. Systems run by the ECS already defer the entity_* calls they make.
+typedef struct ecs_command_buffer ecs_command_buffer;
+
 void ecs_init();
 void ecs_shutdown();
 void ecs_for_each(entity_components filter, ecs_entity_iter_fn fn);
 
+ecs_query* ecs_query_create(entity_components with, entity_components without);
+void ecs_query_destroy(ecs_query* query);
+u32 ecs_query_count(const ecs_query* query);
+ecs_query_iter ecs_query_iter_begin(const ecs_query* query);
+u8 ecs_query_iter_next(ecs_query_iter* it);
+void* _ecs_query_iter_column(const ecs_query_iter* it, entity_components component);
+
+ecs_command_buffer* ecs_command_buffer_create();
+void ecs_command_buffer_destroy(ecs_command_buffer* cb);
+entity_id ecs_command_buffer_create_entity(ecs_command_buffer* cb);
+void ecs_command_buffer_destroy_entity(ecs_command_buffer* cb, entity_id entity);
+void ecs_command_buffer_add_component(ecs_command_buffer* cb, entity_id entity, const void* component_data, entity_components component);
+void ecs_command_buffer_remove_component(ecs_command_buffer* cb, entity_id entity, entity_components component);
+void ecs_command_buffer_playback(ecs_command_buffer* cb);
+
 void ecs_initialize_scripts();
 void ecs_update_scripts(f32 delta_time);
 void ecs_shutdown_scripts();
 
 // Component functions
 void ecs_update_sprite_animations(f32 delta_time);
-void ecs_draw_sprites();
+void ecs_draw_sprites(); // Sorted by depth then texture to keep texture switches and flushes down
+
+// Per span versions of the component functions, used by the scheduler to split the work
+void ecs_update_sprite_animations_span(const ecs_query_iter* it, f32 delta_time);
+void ecs_draw_sprites_span(const ecs_query_iter* it); // Submission order, no sorting
 
 entity_id entity_create();
 void entity_add_component(entity_id entity, const void* component_data, entity_components component);
 void entity_add_custom_component(entity_id entity, const void* custom_component, u64 custom_component_size);
 u8 entity_has_component(entity_id entity, entity_components components);
+u8 entity_is_alive(entity_id entity);
 void entity_remove_component(entity_id entity, entity_components component);
 void entity_destroy(entity_id entity);
 void* _entity_get_component(entity_id entity, entity_components component);
@@ -39,6 +83,17 @@ void* _entity_get_component(entity_id entity, entity_components component);
 // Helpers for getting components
 
 #define entity_get_transform(entity) ((transform_component*)_entity_get_component(entity, ENTITY_COMPONENT_TRANSFORM))
+#define entity_get_rigidbody(entity) ((rigidbody_component*)_entity_get_component(entity, ENTITY_COMPONENT_RIGIDBODY))
 #define entity_get_script(entity) ((script_component*)_entity_get_component(entity, ENTITY_COMPONENT_SCRIPT))
 #define entity_get_custom(entity, cast_type) ((cast_type*)_entity_get_component(entity, ENTITY_COMPONENT_CUSTOM))
-#define entity_get_sprite(entity) ((sprite_component*)_entity_get_component(entity, ENTITY_COMPONENT_SPRITE))
\ No newline at end of file
+#define entity_get_sprite(entity) ((sprite_component*)_entity_get_component(entity, ENTITY_COMPONENT_SPRITE))
+#define entity_get_collider(entity) ((collider_component*)_entity_get_component(entity, ENTITY_COMPONENT_COLLIDER))
+
+// Helpers for getting the component arrays of a query span
+
+#define ecs_iter_transforms(it) ((transform_component*)_ecs_query_iter_column(it, ENTITY_COMPONENT_TRANSFORM))
+#define ecs_iter_rigidbodies(it) ((rigidbody_component*)_ecs_query_iter_column(it, ENTITY_COMPONENT_RIGIDBODY))
+#define ecs_iter_scripts(it) ((script_component*)_ecs_query_iter_column(it, ENTITY_COMPONENT_SCRIPT))
+#define ecs_iter_customs(it, cast_type) ((cast_type*)_ecs_query_iter_column(it, ENTITY_COMPONENT_CUSTOM))
+#define ecs_iter_sprites(it) ((sprite_component*)_ecs_query_iter_column(it, ENTITY_COMPONENT_SPRITE))
+#define ecs_iter_colliders(it) ((collider_component*)_ecs_query_iter_column(it, ENTITY_COMPONENT_COLLIDER))
\ No newline at end of file
@@ -2,4 +2,13 @@
 
 #include <common.h>
 
-typedef u64 entity_id;
\ No newline at end of file
+// An entity id is a generational index: the low 32 bits are the slot in the registry's
+// sparse table and the high 32 bits are the generation of that slot when the id was handed out.
+// Destroying an entity bumps the generation, so any old copies of the id are detected as stale.
+typedef u64 entity_id;
+
+#define ENTITY_NULL ((entity_id)0)
+
+#define entity_id_make(slot, generation) ((((entity_id)(generation)) << 32) | (entity_id)(slot))
+#define entity_id_slot(entity) ((u32)((entity) & 0xFFFFFFFFULL))
+#define entity_id_generation(entity) ((u32)((entity) >> 32))
\ No newline at end of file
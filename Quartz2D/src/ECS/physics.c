@@ -0,0 +1,394 @@
+#include <ECS/physics.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_M_X64) || defined(__SSE__)
+#define PHYSICS_SIMD
+#include <immintrin.h>
+#endif
+
+// -- INTEGRATION --
+
+#ifdef PHYSICS_SIMD
+
+// One body per iteration, the four lanes are x, y, z and rotation
+static void internal_integrate_sse(transform_component* transforms, rigidbody_component* bodies, u32 count, f32 delta_time) {
+    const __m128 dt = _mm_set1_ps(delta_time);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    for (u32 i = 0; i < count; i++) {
+        rigidbody_component* body = &bodies[i];
+
+        __m128 velocity = _mm_load_ps(&body->velocity_x);
+        __m128 acceleration = _mm_load_ps(&body->acceleration_x);
+        __m128 damping = _mm_set_ps(body->angular_damping, body->linear_damping, body->linear_damping, body->linear_damping);
+        __m128 position = _mm_load_ps(&transforms[i].x);
+
+        velocity = _mm_add_ps(velocity, _mm_mul_ps(acceleration, dt));
+        velocity = _mm_div_ps(velocity, _mm_add_ps(one, _mm_mul_ps(damping, dt)));
+        position = _mm_add_ps(position, _mm_mul_ps(velocity, dt));
+
+        _mm_store_ps(&body->velocity_x, velocity);
+        _mm_store_ps(&transforms[i].x, position);
+    }
+}
+
+#ifdef __AVX__
+
+// Two bodies per iteration, their transforms are adjacent so they load as one 256 bit register
+static u32 internal_integrate_avx(transform_component* transforms, rigidbody_component* bodies, u32 count, f32 delta_time) {
+    const __m256 dt = _mm256_set1_ps(delta_time);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    u32 i = 0;
+    for (; i + 2 <= count; i += 2) {
+        rigidbody_component* a = &bodies[i];
+        rigidbody_component* b = &bodies[i + 1];
+
+        __m256 velocity = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(&a->velocity_x)), _mm_load_ps(&b->velocity_x), 1);
+        __m256 acceleration = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(&a->acceleration_x)), _mm_load_ps(&b->acceleration_x), 1);
+        __m256 damping = _mm256_set_ps(
+            b->angular_damping, b->linear_damping, b->linear_damping, b->linear_damping,
+            a->angular_damping, a->linear_damping, a->linear_damping, a->linear_damping);
+        __m256 position = _mm256_loadu_ps(&transforms[i].x);
+
+        velocity = _mm256_add_ps(velocity, _mm256_mul_ps(acceleration, dt));
+        velocity = _mm256_div_ps(velocity, _mm256_add_ps(one, _mm256_mul_ps(damping, dt)));
+        position = _mm256_add_ps(position, _mm256_mul_ps(velocity, dt));
+
+        _mm_store_ps(&a->velocity_x, _mm256_castps256_ps128(velocity));
+        _mm_store_ps(&b->velocity_x, _mm256_extractf128_ps(velocity, 1));
+        _mm256_storeu_ps(&transforms[i].x, position);
+    }
+
+    return i;
+}
+
+#endif
+
+#else
+
+static void internal_integrate_scalar(transform_component* transforms, rigidbody_component* bodies, u32 count, f32 delta_time) {
+    for (u32 i = 0; i < count; i++) {
+        rigidbody_component* body = &bodies[i];
+        transform_component* t = &transforms[i];
+
+        f32 linear = 1.0f + body->linear_damping * delta_time;
+        f32 angular = 1.0f + body->angular_damping * delta_time;
+
+        body->velocity_x = (body->velocity_x + body->acceleration_x * delta_time) / linear;
+        body->velocity_y = (body->velocity_y + body->acceleration_y * delta_time) / linear;
+        body->velocity_z = (body->velocity_z + body->acceleration_z * delta_time) / linear;
+        body->angular_velocity = (body->angular_velocity + body->angular_acceleration * delta_time) / angular;
+
+        t->x += body->velocity_x * delta_time;
+        t->y += body->velocity_y * delta_time;
+        t->z += body->velocity_z * delta_time;
+        t->rotation += body->angular_velocity * delta_time;
+    }
+}
+
+#endif
+
+void ecs_integrate_rigidbodies_span(const ecs_query_iter* it, f32 delta_time) {
+    transform_component* transforms = ecs_iter_transforms(it);
+    rigidbody_component* bodies = ecs_iter_rigidbodies(it);
+    if (!transforms || !bodies) return;
+
+#ifdef PHYSICS_SIMD
+    u32 done = 0;
+#ifdef __AVX__
+    done = internal_integrate_avx(transforms, bodies, it->count, delta_time);
+#endif
+    internal_integrate_sse(transforms + done, bodies + done, it->count - done, delta_time);
+#else
+    internal_integrate_scalar(transforms, bodies, it->count, delta_time);
+#endif
+}
+
+// -- INTEGRATION --
+
+// -- BROADPHASE --
+
+typedef struct {
+    entity_id entity;
+    f32 min_x, min_y, max_x, max_y;
+    f32 center_x, center_y;
+    f32 radius;
+    u32 shape;
+    u32 layer;
+    u32 mask;
+} broadphase_body;
+
+typedef struct {
+    i32 cell_x;
+    i32 cell_y;
+    u32 body;
+} broadphase_entry;
+
+struct ecs_broadphase {
+    f32 cell_size;
+    f32 inverse_cell_size;
+    ecs_query* query;
+
+    broadphase_body* bodies;
+    u32 body_count;
+    u32 body_capacity;
+
+    // Entries are counting sorted by bucket, so the bodies of a cell end up next to each other
+    broadphase_entry* entries;
+    broadphase_entry* sorted;
+    u32 entry_count;
+    u32 entry_capacity;
+    u32 sorted_capacity;
+
+    u32* bucket_starts; // bucket_count + 1 prefix sums
+    u32 bucket_count;
+
+    collision_pair* pairs;
+    u32 pair_count;
+    u32 pair_capacity;
+};
+
+// Cell coordinates are clamped to this range, bodies further out all share the border cells
+#define BROADPHASE_CELL_LIMIT (1 << 20)
+// Bodies covering more cells than this are left out of the grid, such worlds want a bigger cell size
+#define BROADPHASE_MAX_BODY_CELLS (1u << 16)
+// Keeps the capacity doubling and the bucket count from wrapping
+#define BROADPHASE_MAX_ENTRIES (1u << 28)
+
+// NULL if the allocation fails, array and capacity are then left as they were
+static void* internal_reserve(void* array, u32* capacity, u32 required, u32 element_size) {
+    if (required <= *capacity) return array;
+
+    u32 new_capacity = *capacity ? *capacity : 256;
+    while (new_capacity < required) {
+        new_capacity *= 2;
+    }
+
+    void* grown = realloc(array, (size_t)new_capacity * element_size);
+    if (grown) {
+        *capacity = new_capacity;
+    }
+    return grown;
+}
+
+static i32 internal_cell(const ecs_broadphase* broadphase, f32 value) {
+    f32 cell = floorf(value * broadphase->inverse_cell_size);
+    if (cell < (f32)-BROADPHASE_CELL_LIMIT) return -BROADPHASE_CELL_LIMIT;
+    if (cell > (f32)BROADPHASE_CELL_LIMIT) return BROADPHASE_CELL_LIMIT;
+    return (i32)cell;
+}
+
+static u32 internal_hash_cell(i32 x, i32 y, u32 bucket_count) {
+    return (((u32)x * 73856093u) ^ ((u32)y * 19349663u)) & (bucket_count - 1);
+}
+
+static void internal_gather_bodies(ecs_broadphase* broadphase) {
+    broadphase->body_count = 0;
+
+    ecs_query_iter it = ecs_query_iter_begin(broadphase->query);
+    while (ecs_query_iter_next(&it)) {
+        const transform_component* transforms = ecs_iter_transforms(&it);
+        const collider_component* colliders = ecs_iter_colliders(&it);
+
+        broadphase_body* bodies = (broadphase_body*)internal_reserve(broadphase->bodies, &broadphase->body_capacity, broadphase->body_count + it.count, sizeof(broadphase_body));
+        if (!bodies) return; // Out of memory, the bodies gathered so far still collide
+        broadphase->bodies = bodies;
+
+        for (u32 i = 0; i < it.count; i++) {
+            const collider_component* c = &colliders[i];
+            broadphase_body* body = &broadphase->bodies[broadphase->body_count];
+
+            body->entity = it.entities[i];
+            body->center_x = transforms[i].x + c->offset_x;
+            body->center_y = transforms[i].y + c->offset_y;
+            body->shape = c->shape;
+            body->layer = c->layer;
+            body->mask = c->mask;
+
+            f32 half_width = c->shape == COLLIDER_SHAPE_CIRCLE ? c->radius : c->half_width;
+            f32 half_height = c->shape == COLLIDER_SHAPE_CIRCLE ? c->radius : c->half_height;
+            body->radius = c->radius;
+            body->min_x = body->center_x - half_width;
+            body->min_y = body->center_y - half_height;
+            body->max_x = body->center_x + half_width;
+            body->max_y = body->center_y + half_height;
+
+            // NaN or infinite bounds have no cell, the body is left out rather than poisoning the grid
+            if (!isfinite(body->min_x) || !isfinite(body->min_y) || !isfinite(body->max_x) || !isfinite(body->max_y)) continue;
+            broadphase->body_count++;
+        }
+    }
+}
+
+static void internal_build_grid(ecs_broadphase* broadphase) {
+    broadphase->entry_count = 0;
+
+    for (u32 i = 0; i < broadphase->body_count; i++) {
+        const broadphase_body* body = &broadphase->bodies[i];
+        i32 x0 = internal_cell(broadphase, body->min_x), x1 = internal_cell(broadphase, body->max_x);
+        i32 y0 = internal_cell(broadphase, body->min_y), y1 = internal_cell(broadphase, body->max_y);
+
+        u64 cells = (u64)(x1 - x0 + 1) * (u64)(y1 - y0 + 1);
+        if (cells > BROADPHASE_MAX_BODY_CELLS || broadphase->entry_count + cells > BROADPHASE_MAX_ENTRIES) continue;
+
+        broadphase_entry* entries = (broadphase_entry*)internal_reserve(broadphase->entries, &broadphase->entry_capacity, broadphase->entry_count + (u32)cells, sizeof(broadphase_entry));
+        if (!entries) continue;
+        broadphase->entries = entries;
+
+        for (i32 y = y0; y <= y1; y++) {
+            for (i32 x = x0; x <= x1; x++) {
+                broadphase_entry* entry = &broadphase->entries[broadphase->entry_count++];
+                entry->cell_x = x;
+                entry->cell_y = y;
+                entry->body = i;
+            }
+        }
+    }
+
+    broadphase_entry* sorted = (broadphase_entry*)internal_reserve(broadphase->sorted, &broadphase->sorted_capacity, broadphase->entry_count, sizeof(broadphase_entry));
+    if (sorted) {
+        broadphase->sorted = sorted;
+    } else {
+        broadphase->entry_count = 0; // Out of memory, every bucket stays empty this frame
+    }
+
+    // About two buckets per entry keeps unrelated cells from sharing a bucket
+    u32 bucket_count = 64;
+    while (bucket_count < broadphase->entry_count * 2) {
+        bucket_count *= 2;
+    }
+
+    if (bucket_count != broadphase->bucket_count) {
+        free(broadphase->bucket_starts);
+        broadphase->bucket_starts = (u32*)malloc(sizeof(u32) * (bucket_count + 1));
+        broadphase->bucket_count = broadphase->bucket_starts ? bucket_count : 0; // No buckets means no pairs
+        if (!broadphase->bucket_starts) return;
+    }
+
+    u32* starts = broadphase->bucket_starts;
+    memset(starts, 0, sizeof(u32) * (bucket_count + 1));
+
+    for (u32 i = 0; i < broadphase->entry_count; i++) {
+        const broadphase_entry* entry = &broadphase->entries[i];
+        starts[internal_hash_cell(entry->cell_x, entry->cell_y, bucket_count) + 1]++;
+    }
+
+    for (u32 b = 0; b < bucket_count; b++) {
+        starts[b + 1] += starts[b];
+    }
+
+    // Scatter, bumping the start of each bucket and restoring it afterwards
+    for (u32 i = 0; i < broadphase->entry_count; i++) {
+        const broadphase_entry* entry = &broadphase->entries[i];
+        u32 bucket = internal_hash_cell(entry->cell_x, entry->cell_y, bucket_count);
+        broadphase->sorted[starts[bucket]++] = *entry;
+    }
+
+    for (u32 b = bucket_count; b > 0; b--) {
+        starts[b] = starts[b - 1];
+    }
+    starts[0] = 0;
+}
+
+static u8 internal_shapes_touch(const broadphase_body* a, const broadphase_body* b) {
+    if (a->shape == COLLIDER_SHAPE_AABB && b->shape == COLLIDER_SHAPE_AABB) return true; // Bounds already overlap
+
+    if (a->shape == COLLIDER_SHAPE_CIRCLE && b->shape == COLLIDER_SHAPE_CIRCLE) {
+        f32 dx = a->center_x - b->center_x;
+        f32 dy = a->center_y - b->center_y;
+        f32 r = a->radius + b->radius;
+        return dx * dx + dy * dy <= r * r;
+    }
+
+    // Circle against box, closest point on the box to the circle center
+    const broadphase_body* circle = a->shape == COLLIDER_SHAPE_CIRCLE ? a : b;
+    const broadphase_body* box = a->shape == COLLIDER_SHAPE_CIRCLE ? b : a;
+
+    f32 x = fmaxf(box->min_x, fminf(circle->center_x, box->max_x));
+    f32 y = fmaxf(box->min_y, fminf(circle->center_y, box->max_y));
+    f32 dx = circle->center_x - x;
+    f32 dy = circle->center_y - y;
+    return dx * dx + dy * dy <= circle->radius * circle->radius;
+}
+
+static void internal_find_pairs(ecs_broadphase* broadphase) {
+    broadphase->pair_count = 0;
+
+    for (u32 bucket = 0; bucket < broadphase->bucket_count; bucket++) {
+        u32 begin = broadphase->bucket_starts[bucket];
+        u32 end = broadphase->bucket_starts[bucket + 1];
+
+        for (u32 i = begin; i < end; i++) {
+            const broadphase_entry* ei = &broadphase->sorted[i];
+            const broadphase_body* a = &broadphase->bodies[ei->body];
+
+            for (u32 j = i + 1; j < end; j++) {
+                const broadphase_entry* ej = &broadphase->sorted[j];
+                if (ej->cell_x != ei->cell_x || ej->cell_y != ei->cell_y) continue; // Another cell in the same bucket
+
+                const broadphase_body* b = &broadphase->bodies[ej->body];
+                if (!(a->layer & b->mask) || !(b->layer & a->mask)) continue;
+
+                if (a->max_x < b->min_x || b->max_x < a->min_x) continue;
+                if (a->max_y < b->min_y || b->max_y < a->min_y) continue;
+
+                // Bodies sharing several cells are only reported from the cell holding the corner of their overlap
+                if (internal_cell(broadphase, fmaxf(a->min_x, b->min_x)) != ei->cell_x) continue;
+                if (internal_cell(broadphase, fmaxf(a->min_y, b->min_y)) != ei->cell_y) continue;
+
+                if (!internal_shapes_touch(a, b)) continue;
+
+                collision_pair* pairs = (collision_pair*)internal_reserve(broadphase->pairs, &broadphase->pair_capacity, broadphase->pair_count + 1, sizeof(collision_pair));
+                if (!pairs) return; // Out of memory, the pairs found so far are reported
+                broadphase->pairs = pairs;
+
+                collision_pair* pair = &broadphase->pairs[broadphase->pair_count++];
+                pair->a = a->entity;
+                pair->b = b->entity;
+            }
+        }
+    }
+}
+
+ecs_broadphase* ecs_broadphase_create(f32 cell_size) {
+    if (cell_size <= 0.0f) return NULL;
+
+    ecs_broadphase* broadphase = (ecs_broadphase*)calloc(1, sizeof(ecs_broadphase));
+    if (!broadphase) return NULL;
+
+    broadphase->cell_size = cell_size;
+    broadphase->inverse_cell_size = 1.0f / cell_size;
+    broadphase->query = ecs_query_create(ENTITY_COMPONENT_TRANSFORM | ENTITY_COMPONENT_COLLIDER, 0);
+
+    return broadphase;
+}
+
+void ecs_broadphase_destroy(ecs_broadphase* broadphase) {
+    if (!broadphase) return;
+
+    ecs_query_destroy(broadphase->query);
+
+    free(broadphase->bodies);
+    free(broadphase->entries);
+    free(broadphase->sorted);
+    free(broadphase->bucket_starts);
+    free(broadphase->pairs);
+    free(broadphase);
+}
+
+void ecs_broadphase_update(ecs_broadphase* broadphase) {
+    internal_gather_bodies(broadphase);
+    internal_build_grid(broadphase);
+    internal_find_pairs(broadphase);
+}
+
+const collision_pair* ecs_broadphase_get_pairs(const ecs_broadphase* broadphase, u32* out_count) {
+    *out_count = broadphase->pair_count;
+    return broadphase->pairs;
+}
+
+// -- BROADPHASE --
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <common.h>
+#include <ECS/ecs.h>
+
+// Semi-implicit Euler integration of every rigidbody into its transform:
+//   velocity += acceleration * dt, velocity *= 1 / (1 + damping * dt), transform += velocity * dt
+// The span must come from a query with both ENTITY_COMPONENT_TRANSFORM and ENTITY_COMPONENT_RIGIDBODY.
+void ecs_integrate_rigidbodies_span(const ecs_query_iter* it, f32 delta_time);
+
+// Uniform grid broadphase. Every update rebuilds a spatial hash of all colliders, tests only the
+// colliders that share a cell, runs the exact shape test and keeps the touching pairs.
+// Colliders with non-finite bounds or covering more than 65536 cells are skipped.
+// Destroy it before ecs_shutdown, like any other object owning a query.
+typedef struct ecs_broadphase ecs_broadphase;
+
+typedef struct {
+	entity_id a;
+	entity_id b;
+} collision_pair;
+
+ecs_broadphase* ecs_broadphase_create(f32 cell_size); // Pick about the size of the common colliders
+void ecs_broadphase_destroy(ecs_broadphase* broadphase);
+void ecs_broadphase_update(ecs_broadphase* broadphase);
+const collision_pair* ecs_broadphase_get_pairs(const ecs_broadphase* broadphase, u32* out_count); // Valid until the next update
@@ -0,0 +1,284 @@
+#include <ECS/scheduler.h>
+
+#include <ECS/physics.h>
+#include <core/job_system.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// -- INTERNAL STRUCTURES --
+
+typedef struct {
+    ecs_system_desc desc;
+    ecs_query* query;  // NULL for systems that run once per frame
+    u32 level;         // Systems on the same level never conflict and may run together
+} ecs_system;
+
+typedef struct {
+    ecs_scheduler* scheduler;
+    u32 system;
+    u8 has_span;          // false means run the whole system (every span of its query, or once)
+    ecs_query_iter span;
+} ecs_task;
+
+struct ecs_scheduler {
+    ecs_system systems[ECS_MAX_SYSTEMS];
+    u32 system_count;
+
+    ecs_task* tasks;    // Submitted to the job system, any thread may run them
+    u32 task_count;
+    u32 task_capacity;
+
+    ecs_task* main_tasks; // Tasks pinned to the thread calling ecs_scheduler_run
+    u32 main_task_count;
+    u32 main_task_capacity;
+
+    ecs_command_buffer** commands; // One per job system thread
+    u32 command_buffer_count;
+    f32 delta_time;
+};
+
+// -- INTERNAL STRUCTURES --
+
+// -- INTERNAL FUNCTIONS --
+
+static u8 systems_conflict(const ecs_system_desc* a, const ecs_system_desc* b) {
+    if ((a->flags | b->flags) & ECS_SYSTEM_EXCLUSIVE) return true;
+    if ((a->flags & b->flags) & ECS_SYSTEM_MAIN_THREAD) return true; // Keeps main thread systems in registration order
+
+    return (a->writes & (b->reads | b->writes)) != 0 || (b->writes & a->reads) != 0;
+}
+
+// False if the list can't grow, the list and its capacity are then left as they were
+static u8 internal_push_task(ecs_task** tasks, u32* count, u32* capacity, ecs_task task) {
+    if (*count == *capacity) {
+        u32 new_capacity = *capacity ? *capacity * 2 : 64;
+        ecs_task* grown = (ecs_task*)realloc(*tasks, sizeof(ecs_task) * new_capacity);
+        if (!grown) return false;
+
+        *tasks = grown;
+        *capacity = new_capacity;
+    }
+    (*tasks)[(*count)++] = task;
+    return true;
+}
+
+static void internal_execute_task(void* data) {
+    const ecs_task* task = (const ecs_task*)data;
+    ecs_scheduler* scheduler = task->scheduler;
+    const ecs_system* system = &scheduler->systems[task->system];
+    u32 thread_index = job_system_thread_index();
+
+    ecs_system_context ctx = {
+        .delta_time = scheduler->delta_time,
+        .commands = scheduler->commands[thread_index],
+        .span = NULL,
+        .user_data = system->desc.user_data,
+        .thread_index = thread_index
+    };
+
+    if (task->has_span) {
+        ctx.span = &task->span;
+        system->desc.run(&ctx);
+    }
+    else if (system->query) {
+        ecs_query_iter it = ecs_query_iter_begin(system->query);
+        while (ecs_query_iter_next(&it)) {
+            ctx.span = &it;
+            system->desc.run(&ctx);
+        }
+    }
+    else {
+        system->desc.run(&ctx);
+    }
+}
+
+// Runs one level worth of tasks, the calling thread runs the pinned tasks and then helps out
+static void internal_run_batch(ecs_scheduler* scheduler) {
+    job_counter counter = { 0 };
+
+    for (u32 i = 0; i < scheduler->task_count; i++) {
+        job_system_submit(internal_execute_task, &scheduler->tasks[i], &counter);
+    }
+
+    for (u32 i = 0; i < scheduler->main_task_count; i++) {
+        internal_execute_task(&scheduler->main_tasks[i]);
+    }
+
+    job_system_wait(&counter);
+}
+
+// -- INTERNAL FUNCTIONS --
+
+// -- SCHEDULER FUNCTIONS --
+
+ecs_scheduler* ecs_scheduler_create() {
+    ecs_scheduler* scheduler = (ecs_scheduler*)calloc(1, sizeof(ecs_scheduler));
+    if (!scheduler) return NULL;
+
+    u32 thread_count = job_system_thread_count();
+    scheduler->commands = (ecs_command_buffer**)calloc(thread_count, sizeof(ecs_command_buffer*));
+    if (!scheduler->commands) {
+        free(scheduler);
+        return NULL;
+    }
+
+    scheduler->command_buffer_count = thread_count;
+    for (u32 i = 0; i < thread_count; i++) {
+        scheduler->commands[i] = ecs_command_buffer_create();
+        if (!scheduler->commands[i]) {
+            ecs_scheduler_destroy(scheduler); // Skips the buffers that were never created
+            return NULL;
+        }
+    }
+
+    return scheduler;
+}
+
+void ecs_scheduler_destroy(ecs_scheduler* scheduler) {
+    if (!scheduler) return;
+
+    for (u32 i = 0; i < scheduler->system_count; i++) {
+        ecs_query_destroy(scheduler->systems[i].query);
+    }
+
+    for (u32 i = 0; i < scheduler->command_buffer_count; i++) {
+        ecs_command_buffer_destroy(scheduler->commands[i]);
+    }
+
+    free(scheduler->commands);
+    free(scheduler->tasks);
+    free(scheduler->main_tasks);
+    free(scheduler);
+}
+
+u8 ecs_scheduler_add_system(ecs_scheduler* scheduler, const ecs_system_desc* desc) {
+    if (scheduler->system_count >= ECS_MAX_SYSTEMS || !desc->run) return false;
+
+    ecs_system* system = &scheduler->systems[scheduler->system_count++];
+    system->desc = *desc;
+    system->query = (desc->with || desc->without) ? ecs_query_create(desc->with, desc->without) : NULL;
+    system->level = 0;
+
+    return true;
+}
+
+void ecs_scheduler_run(ecs_scheduler* scheduler, f32 delta_time) {
+    scheduler->delta_time = delta_time;
+
+    // Build the dependency graph for this frame. A system goes on the level after the last
+    // earlier system it conflicts with, so registration order is kept for every conflict.
+    u32 level_count = 0;
+    for (u32 i = 0; i < scheduler->system_count; i++) {
+        ecs_system* system = &scheduler->systems[i];
+        system->level = 0;
+
+        for (u32 j = 0; j < i; j++) {
+            const ecs_system* earlier = &scheduler->systems[j];
+            if (earlier->level >= system->level && systems_conflict(&earlier->desc, &system->desc)) {
+                system->level = earlier->level + 1;
+            }
+        }
+
+        if (system->level + 1 > level_count) {
+            level_count = system->level + 1;
+        }
+    }
+
+    for (u32 level = 0; level < level_count; level++) {
+        scheduler->task_count = 0;
+        scheduler->main_task_count = 0;
+
+        for (u32 i = 0; i < scheduler->system_count; i++) {
+            const ecs_system* system = &scheduler->systems[i];
+            if (system->level != level) continue;
+
+            u8 main_thread = (system->desc.flags & ECS_SYSTEM_MAIN_THREAD) != 0;
+
+            if (system->query && (system->desc.flags & ECS_SYSTEM_PARALLEL) && !main_thread) {
+                // One task per chunk of matching entities
+                ecs_query_iter it = ecs_query_iter_begin(system->query);
+                while (ecs_query_iter_next(&it)) {
+                    ecs_task task = { .scheduler = scheduler, .system = i, .has_span = true, .span = it };
+                    if (!internal_push_task(&scheduler->tasks, &scheduler->task_count, &scheduler->task_capacity, task)) {
+                        internal_execute_task(&task); // Out of memory, the span runs here instead of in parallel
+                    }
+                }
+            }
+            else {
+                ecs_task task = { .scheduler = scheduler, .system = i, .has_span = false };
+                u8 pushed = main_thread
+                    ? internal_push_task(&scheduler->main_tasks, &scheduler->main_task_count, &scheduler->main_task_capacity, task)
+                    : internal_push_task(&scheduler->tasks, &scheduler->task_count, &scheduler->task_capacity, task);
+                if (!pushed) {
+                    internal_execute_task(&task); // Out of memory, runs here before the rest of the level
+                }
+            }
+        }
+
+        internal_run_batch(scheduler);
+
+        // Sync point, structural changes recorded on this level become visible to the next one
+        for (u32 i = 0; i < scheduler->command_buffer_count; i++) {
+            ecs_command_buffer_playback(scheduler->commands[i]);
+        }
+    }
+}
+
+// -- SCHEDULER FUNCTIONS --
+
+// -- BUILTIN SYSTEMS --
+
+static void system_update_scripts(const ecs_system_context* ctx) {
+    ecs_update_scripts(ctx->delta_time);
+}
+
+static void system_integrate_rigidbodies(const ecs_system_context* ctx) {
+    ecs_integrate_rigidbodies_span(ctx->span, ctx->delta_time);
+}
+
+static void system_update_sprite_animations(const ecs_system_context* ctx) {
+    ecs_update_sprite_animations_span(ctx->span, ctx->delta_time);
+}
+
+static void system_draw_sprites(const ecs_system_context* ctx) {
+    (void)ctx;
+    ecs_draw_sprites(); // Sorts across every span, so the system has no query of its own
+}
+
+void ecs_scheduler_add_builtin_systems(ecs_scheduler* scheduler) {
+    ecs_system_desc scripts = {
+        .name = "scripts",
+        .flags = ECS_SYSTEM_EXCLUSIVE | ECS_SYSTEM_MAIN_THREAD,
+        .run = system_update_scripts
+    };
+    ecs_scheduler_add_system(scheduler, &scripts);
+
+    ecs_system_desc rigidbodies = {
+        .name = "integrate_rigidbodies",
+        .writes = ENTITY_COMPONENT_TRANSFORM | ENTITY_COMPONENT_RIGIDBODY,
+        .with = ENTITY_COMPONENT_TRANSFORM | ENTITY_COMPONENT_RIGIDBODY,
+        .flags = ECS_SYSTEM_PARALLEL,
+        .run = system_integrate_rigidbodies
+    };
+    ecs_scheduler_add_system(scheduler, &rigidbodies);
+
+    ecs_system_desc animations = {
+        .name = "sprite_animations",
+        .writes = ENTITY_COMPONENT_SPRITE,
+        .with = ENTITY_COMPONENT_SPRITE,
+        .flags = ECS_SYSTEM_PARALLEL,
+        .run = system_update_sprite_animations
+    };
+    ecs_scheduler_add_system(scheduler, &animations);
+
+    ecs_system_desc draw_sprites = {
+        .name = "draw_sprites",
+        .reads = ENTITY_COMPONENT_TRANSFORM | ENTITY_COMPONENT_SPRITE,
+        .flags = ECS_SYSTEM_MAIN_THREAD,
+        .run = system_draw_sprites
+    };
+    ecs_scheduler_add_system(scheduler, &draw_sprites);
+}
+
+// -- BUILTIN SYSTEMS --
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <common.h>
+#include <ECS/ecs.h>
+
+// Runs registered systems every frame. Each system declares the components it reads and
+// writes, systems that do not conflict run at the same time as jobs on the job system, and a
+// system flagged ECS_SYSTEM_PARALLEL is additionally split into one job per query span (chunk).
+
+#define ECS_MAX_SYSTEMS 32
+
+typedef enum {
+	ECS_SYSTEM_PARALLEL = (1 << 0),     // Spans of the system's query may run on different threads
+	ECS_SYSTEM_MAIN_THREAD = (1 << 1),  // Always runs on the thread calling ecs_scheduler_run (renderer, input)
+	ECS_SYSTEM_EXCLUSIVE = (1 << 2)     // Conflicts with every other system (arbitrary entity access, scripts)
+} ecs_system_flags;
+
+typedef struct {
+	f32 delta_time;
+	ecs_command_buffer* commands;  // Structural changes from worker threads must be recorded here
+	const ecs_query_iter* span;    // The entities to process, NULL for systems without a query
+	void* user_data;
+	u32 thread_index;
+} ecs_system_context;
+
+typedef void (*ecs_system_fn)(const ecs_system_context* ctx);
+
+typedef struct {
+	const char* name;
+	entity_components reads;
+	entity_components writes;
+	entity_components with;     // Query of the system, leave with and without at 0 to be called once per frame
+	entity_components without;
+	u32 flags;
+	ecs_system_fn run;
+	void* user_data;
+} ecs_system_desc;
+
+typedef struct ecs_scheduler ecs_scheduler;
+
+ecs_scheduler* ecs_scheduler_create(); // The job system must be initialized first, NULL if out of memory
+void ecs_scheduler_destroy(ecs_scheduler* scheduler);
+u8 ecs_scheduler_add_system(ecs_scheduler* scheduler, const ecs_system_desc* desc);
+void ecs_scheduler_add_builtin_systems(ecs_scheduler* scheduler);
+void ecs_scheduler_run(ecs_scheduler* scheduler, f32 delta_time);
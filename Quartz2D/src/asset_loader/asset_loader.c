@@ -1,5 +1,6 @@
 #include <asset_loader/asset_loader.h>
 #include <asset_loader/tga_loader.h>
+#include <renderer/texture_array.h>
 
 #include <stdlib.h>
 #include <string.h>
@@ -10,28 +11,16 @@ i32 asset_loader_load_texture_from_tga(const char* filepath) {
         return -1;
     }
 
-    GLuint tex_id = 0;
-    glGenTextures(1, &tex_id);
-    glBindTexture(GL_TEXTURE_2D, tex_id);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.data);
-
-    // Basic filtering and wrapping
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-    // Generate mipmaps
-    glGenerateMipmap(GL_TEXTURE_2D);
+    // Goes into a layer of one of the renderer's texture pages
+    i32 tex_id = texture_array_create((i32)image.width, (i32)image.height, image.data);
 
     tga_free(&image);
-    return (i32)tex_id;
+    return tex_id;
 }
 
 void asset_loader_destroy_texture(i32 tex_id) {
     if (tex_id != -1) {
-        glDeleteTextures(1, (GLuint*)&tex_id);
+        texture_array_destroy(tex_id);
     }
 }
 
@@ -41,19 +30,13 @@ texture_atlas asset_loader_load_texture_atlas_from_tga(const char* filepath, i32
         return (texture_atlas) { .texture_id = -1 };
     }
 
-    GLuint tex_id = 0;
-    glGenTextures(1, &tex_id);
-    glBindTexture(GL_TEXTURE_2D, tex_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.data);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-    glGenerateMipmap(GL_TEXTURE_2D);
+    i32 tex_id = texture_array_create((i32)image.width, (i32)image.height, image.data);
+    if (tex_id == -1) {
+        tga_free(&image);
+        return (texture_atlas) { .texture_id = -1 };
+    }
 
-    // Compute UVs
+    // Compute UVs, relative to the whole texture, the renderer maps them into its page layer
     i32 cols = image.width / sprite_width;
     i32 rows = image.height / sprite_height;
     i32 max_sprites = cols * rows;
@@ -77,7 +60,7 @@ texture_atlas asset_loader_load_texture_atlas_from_tga(const char* filepath, i32
     tga_free(&image);
 
     return (texture_atlas) {
-        .texture_id = (i32)tex_id,
+        .texture_id = tex_id,
             .sprite_width = sprite_width,
             .sprite_height = sprite_height,
             .atlas_width = image.width,
@@ -89,7 +72,7 @@ texture_atlas asset_loader_load_texture_atlas_from_tga(const char* filepath, i32
 
 void asset_loader_destroy_texture_atlas(texture_atlas* atlas) {
     if (atlas && atlas->texture_id != -1) {
-        glDeleteTextures(1, (GLuint*)&atlas->texture_id);
+        texture_array_destroy(atlas->texture_id);
         free(atlas->uvs);
         atlas->texture_id = -1;
     }
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <common.h>
+
+// Small set of sequentially consistent atomics over 32 and 64 bit integers
+
+#ifdef _MSC_VER
+
+#include <intrin.h>
+
+static __inline i32 atomic_load_i32(volatile i32* value) { return _InterlockedOr((volatile long*)value, 0); }
+static __inline void atomic_store_i32(volatile i32* value, i32 desired) { _InterlockedExchange((volatile long*)value, desired); }
+static __inline i32 atomic_add_i32(volatile i32* value, i32 amount) { return _InterlockedExchangeAdd((volatile long*)value, amount); } // Returns the previous value
+static __inline i32 atomic_exchange_i32(volatile i32* value, i32 desired) { return _InterlockedExchange((volatile long*)value, desired); }
+static __inline u8 atomic_compare_exchange_i32(volatile i32* value, i32 expected, i32 desired) {
+    return _InterlockedCompareExchange((volatile long*)value, desired, expected) == expected;
+}
+
+static __inline i64 atomic_load_i64(volatile i64* value) { return _InterlockedOr64(value, 0); }
+static __inline void atomic_store_i64(volatile i64* value, i64 desired) { _InterlockedExchange64(value, desired); }
+static __inline i64 atomic_add_i64(volatile i64* value, i64 amount) { return _InterlockedExchangeAdd64(value, amount); }
+static __inline u8 atomic_compare_exchange_i64(volatile i64* value, i64 expected, i64 desired) {
+    return _InterlockedCompareExchange64(value, desired, expected) == expected;
+}
+
+static __inline void* atomic_load_ptr(void* volatile* value) { return _InterlockedCompareExchangePointer(value, (void*)0, (void*)0); }
+static __inline void atomic_store_ptr(void* volatile* value, void* desired) { _InterlockedExchangePointer(value, desired); }
+
+static __inline void atomic_thread_fence() { _ReadWriteBarrier(); _mm_mfence(); }
+
+#else
+
+static __inline i32 atomic_load_i32(volatile i32* value) { return __atomic_load_n(value, __ATOMIC_SEQ_CST); }
+static __inline void atomic_store_i32(volatile i32* value, i32 desired) { __atomic_store_n(value, desired, __ATOMIC_SEQ_CST); }
+static __inline i32 atomic_add_i32(volatile i32* value, i32 amount) { return __atomic_fetch_add(value, amount, __ATOMIC_SEQ_CST); } // Returns the previous value
+static __inline i32 atomic_exchange_i32(volatile i32* value, i32 desired) { return __atomic_exchange_n(value, desired, __ATOMIC_SEQ_CST); }
+static __inline u8 atomic_compare_exchange_i32(volatile i32* value, i32 expected, i32 desired) {
+    return __atomic_compare_exchange_n(value, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static __inline i64 atomic_load_i64(volatile i64* value) { return __atomic_load_n(value, __ATOMIC_SEQ_CST); }
+static __inline void atomic_store_i64(volatile i64* value, i64 desired) { __atomic_store_n(value, desired, __ATOMIC_SEQ_CST); }
+static __inline i64 atomic_add_i64(volatile i64* value, i64 amount) { return __atomic_fetch_add(value, amount, __ATOMIC_SEQ_CST); }
+static __inline u8 atomic_compare_exchange_i64(volatile i64* value, i64 expected, i64 desired) {
+    return __atomic_compare_exchange_n(value, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static __inline void* atomic_load_ptr(void* volatile* value) { return __atomic_load_n(value, __ATOMIC_SEQ_CST); }
+static __inline void atomic_store_ptr(void* volatile* value, void* desired) { __atomic_store_n(value, desired, __ATOMIC_SEQ_CST); }
+
+static __inline void atomic_thread_fence() { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+
+#endif
@@ -0,0 +1,405 @@
+#include <core/job_system.h>
+
+#include <core/thread.h>
+#include <core/atomic.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// -- INTERNAL STRUCTURES --
+
+#define JOB_DEQUE_CAPACITY 2048                  // Power of two, a full deque runs new jobs inline
+#define JOB_POOL_CAPACITY (JOB_DEQUE_CAPACITY * 2) // Jobs are recycled in a ring, larger than the deque so a stolen job is copied before reuse
+#define JOB_SPIN_COUNT 64                        // Failed steal rounds before a worker goes to sleep
+#define JOB_THREAD_NONE 0xFFFFFFFF
+
+typedef struct {
+    job_fn fn;
+    job_range_fn range_fn;
+    void* data;
+    u32 begin;
+    u32 end;
+    job_counter* counter;
+} job;
+
+typedef struct {
+    // Chase-Lev deque, the owner pushes and pops at the bottom, thieves take from the top
+    volatile i64 top;
+    u8 padding0[64 - sizeof(i64)];
+    volatile i64 bottom;
+    u8 padding1[64 - sizeof(i64)];
+    job* volatile slots[JOB_DEQUE_CAPACITY];
+
+    job pool[JOB_POOL_CAPACITY];
+    u32 pool_next;
+
+    u32 index;
+    u32 random_state; // Picks the first victim when stealing
+    u32 depth;        // Nesting of jobs run from job_system_wait, only the outermost one is timed
+
+    volatile i64 jobs_executed;
+    volatile i64 jobs_stolen;
+    volatile i64 busy_ns;
+    volatile i64 idle_ns;
+} job_worker;
+
+typedef struct {
+    job_worker** workers; // Index 0 is the thread that called job_system_init
+    thread* threads;
+    u32 thread_count;
+    u32 started_count; // Worker threads that actually launched, the others keep an empty deque
+
+    mutex sleep_lock;
+    condition wake;
+    volatile i32 pending;  // Jobs pushed but not yet taken by any thread
+    volatile i32 sleeping;
+    volatile i32 shutting_down;
+
+    u8 initialized;
+} job_system;
+
+static job_system jobs = { 0 };
+static THREAD_LOCAL u32 current_thread_index = JOB_THREAD_NONE;
+
+// -- INTERNAL STRUCTURES --
+
+// -- INTERNAL FUNCTIONS --
+
+static job_worker* internal_current_worker() {
+    if (!jobs.initialized || current_thread_index == JOB_THREAD_NONE) return NULL;
+    return jobs.workers[current_thread_index];
+}
+
+static u8 internal_push(job_worker* worker, job* j) {
+    i64 bottom = atomic_load_i64(&worker->bottom);
+    i64 top = atomic_load_i64(&worker->top);
+    if (bottom - top >= JOB_DEQUE_CAPACITY) return false;
+
+    atomic_store_ptr((void* volatile*)&worker->slots[bottom & (JOB_DEQUE_CAPACITY - 1)], j);
+    atomic_store_i64(&worker->bottom, bottom + 1);
+    return true;
+}
+
+static job* internal_pop(job_worker* worker) {
+    i64 bottom = atomic_load_i64(&worker->bottom) - 1;
+    atomic_store_i64(&worker->bottom, bottom);
+    i64 top = atomic_load_i64(&worker->top);
+
+    if (top > bottom) {
+        // Empty, restore the bottom
+        atomic_store_i64(&worker->bottom, top);
+        return NULL;
+    }
+
+    job* j = (job*)atomic_load_ptr((void* volatile*)&worker->slots[bottom & (JOB_DEQUE_CAPACITY - 1)]);
+    if (top != bottom) return j;
+
+    // Last job in the deque, race the thieves for it
+    if (!atomic_compare_exchange_i64(&worker->top, top, top + 1)) {
+        j = NULL;
+    }
+    atomic_store_i64(&worker->bottom, top + 1);
+    return j;
+}
+
+static job* internal_steal(job_worker* victim) {
+    i64 top = atomic_load_i64(&victim->top);
+    i64 bottom = atomic_load_i64(&victim->bottom);
+    if (top >= bottom) return NULL;
+
+    job* j = (job*)atomic_load_ptr((void* volatile*)&victim->slots[top & (JOB_DEQUE_CAPACITY - 1)]);
+    if (!atomic_compare_exchange_i64(&victim->top, top, top + 1)) return NULL;
+
+    return j;
+}
+
+// Copies the job out of its pool slot, the slot may be handed out again once it was taken
+static u8 internal_take_job(job_worker* worker, job* out_job) {
+    job* j = internal_pop(worker);
+    u8 stolen = false;
+
+    if (!j && jobs.thread_count > 1) {
+        worker->random_state ^= worker->random_state << 13;
+        worker->random_state ^= worker->random_state >> 17;
+        worker->random_state ^= worker->random_state << 5;
+
+        u32 start = worker->random_state % jobs.thread_count;
+        for (u32 i = 0; i < jobs.thread_count && !j; i++) {
+            u32 victim = (start + i) % jobs.thread_count;
+            if (victim == worker->index) continue;
+
+            j = internal_steal(jobs.workers[victim]);
+        }
+        stolen = j != NULL;
+    }
+
+    if (!j) return false;
+
+    *out_job = *j;
+    atomic_add_i32(&jobs.pending, -1);
+    if (stolen) atomic_add_i64(&worker->jobs_stolen, 1);
+    return true;
+}
+
+static void internal_execute(job_worker* worker, const job* j) {
+    u64 start = worker && worker->depth == 0 ? thread_clock_ns() : 0;
+    if (worker) worker->depth++;
+
+    if (j->range_fn) {
+        j->range_fn(j->data, j->begin, j->end);
+    }
+    else {
+        j->fn(j->data);
+    }
+
+    if (j->counter) {
+        atomic_add_i32(&j->counter->value, -1);
+    }
+
+    if (!worker) return;
+
+    worker->depth--;
+    atomic_add_i64(&worker->jobs_executed, 1);
+    if (worker->depth == 0) {
+        atomic_add_i64(&worker->busy_ns, (i64)(thread_clock_ns() - start));
+    }
+}
+
+static void internal_submit(const job* j) {
+    if (j->counter) {
+        atomic_add_i32(&j->counter->value, 1);
+    }
+
+    job_worker* worker = internal_current_worker();
+    if (!worker) {
+        // No job system on this thread, run it right away
+        internal_execute(NULL, j);
+        return;
+    }
+
+    job* slot = &worker->pool[worker->pool_next++ & (JOB_POOL_CAPACITY - 1)];
+    *slot = *j;
+
+    // Counted before the push so a worker never sleeps while a job it could take is visible
+    atomic_add_i32(&jobs.pending, 1);
+    if (!internal_push(worker, slot)) {
+        atomic_add_i32(&jobs.pending, -1);
+        internal_execute(worker, j);
+        return;
+    }
+
+    if (atomic_load_i32(&jobs.sleeping) > 0) {
+        mutex_lock(&jobs.sleep_lock);
+        condition_signal(&jobs.wake);
+        mutex_unlock(&jobs.sleep_lock);
+    }
+}
+
+static void internal_worker_main(void* arg) {
+    job_worker* worker = (job_worker*)arg;
+    current_thread_index = worker->index;
+
+    u32 failed_rounds = 0;
+    u64 idle_start = thread_clock_ns();
+
+    while (!atomic_load_i32(&jobs.shutting_down)) {
+        job j;
+        if (internal_take_job(worker, &j)) {
+            atomic_add_i64(&worker->idle_ns, (i64)(thread_clock_ns() - idle_start));
+            internal_execute(worker, &j);
+            idle_start = thread_clock_ns();
+            failed_rounds = 0;
+            continue;
+        }
+
+        if (++failed_rounds < JOB_SPIN_COUNT) {
+            thread_yield();
+            continue;
+        }
+
+        mutex_lock(&jobs.sleep_lock);
+        atomic_add_i32(&jobs.sleeping, 1);
+        while (atomic_load_i32(&jobs.pending) <= 0 && !atomic_load_i32(&jobs.shutting_down)) {
+            condition_wait(&jobs.wake, &jobs.sleep_lock);
+        }
+        atomic_add_i32(&jobs.sleeping, -1);
+        mutex_unlock(&jobs.sleep_lock);
+
+        failed_rounds = 0;
+    }
+}
+
+// -- INTERNAL FUNCTIONS --
+
+// -- JOB SYSTEM FUNCTIONS --
+
+u8 job_system_init(u32 worker_count) {
+    if (jobs.initialized) return false;
+
+    if (worker_count == 0) {
+        u32 cores = thread_hardware_concurrency();
+        worker_count = cores > 1 ? cores - 1 : 0; // The calling thread runs jobs too
+    }
+
+    memset(&jobs, 0, sizeof(job_system));
+    if (!mutex_create(&jobs.sleep_lock)) return false;
+    if (!condition_create(&jobs.wake)) {
+        mutex_destroy(&jobs.sleep_lock);
+        return false;
+    }
+
+    jobs.workers = (job_worker**)calloc(worker_count + 1, sizeof(job_worker*));
+    jobs.threads = (thread*)calloc(worker_count + 1, sizeof(thread));
+    if (!jobs.workers || !jobs.threads) {
+        job_system_shutdown();
+        return false;
+    }
+
+    for (u32 i = 0; i <= worker_count; i++) {
+        job_worker* worker = (job_worker*)calloc(1, sizeof(job_worker));
+        if (!worker) break;
+
+        worker->index = i;
+        worker->random_state = 0x9E3779B9u * (i + 1);
+        jobs.workers[i] = worker;
+        jobs.thread_count++;
+    }
+
+    if (jobs.thread_count == 0) {
+        job_system_shutdown();
+        return false;
+    }
+
+    current_thread_index = 0;
+    jobs.initialized = true;
+
+    jobs.started_count = 1;
+    for (u32 i = 1; i < jobs.thread_count; i++) {
+        if (!thread_create(&jobs.threads[i], internal_worker_main, jobs.workers[i])) break;
+        jobs.started_count++;
+    }
+
+    return true;
+}
+
+void job_system_shutdown() {
+    if (jobs.initialized) {
+        // Anything still queued on this thread runs before the workers go away
+        job_worker* worker = internal_current_worker();
+        job j;
+        while (worker && internal_take_job(worker, &j)) {
+            internal_execute(worker, &j);
+        }
+
+        mutex_lock(&jobs.sleep_lock);
+        atomic_store_i32(&jobs.shutting_down, true);
+        condition_broadcast(&jobs.wake);
+        mutex_unlock(&jobs.sleep_lock);
+
+        for (u32 i = 1; i < jobs.started_count; i++) {
+            thread_join(&jobs.threads[i]);
+        }
+    }
+
+    if (jobs.workers) {
+        for (u32 i = 0; i < jobs.thread_count; i++) {
+            free(jobs.workers[i]);
+        }
+    }
+    free(jobs.workers);
+    free(jobs.threads);
+
+    condition_destroy(&jobs.wake);
+    mutex_destroy(&jobs.sleep_lock);
+
+    memset(&jobs, 0, sizeof(job_system));
+    current_thread_index = JOB_THREAD_NONE;
+}
+
+u32 job_system_thread_count() {
+    return jobs.initialized ? jobs.thread_count : 1;
+}
+
+u32 job_system_thread_index() {
+    return internal_current_worker() ? current_thread_index : 0;
+}
+
+void job_system_submit(job_fn fn, void* data, job_counter* counter) {
+    job j = { .fn = fn, .data = data, .counter = counter };
+    internal_submit(&j);
+}
+
+void job_system_submit_range(job_range_fn fn, void* data, u32 begin, u32 end, job_counter* counter) {
+    job j = { .range_fn = fn, .data = data, .begin = begin, .end = end, .counter = counter };
+    internal_submit(&j);
+}
+
+void job_system_wait(job_counter* counter) {
+    job_worker* worker = internal_current_worker();
+    u64 idle_start = 0;
+
+    while (atomic_load_i32(&counter->value) > 0) {
+        job j;
+        if (worker && internal_take_job(worker, &j)) {
+            if (idle_start && worker->depth == 0) {
+                atomic_add_i64(&worker->idle_ns, (i64)(thread_clock_ns() - idle_start));
+                idle_start = 0;
+            }
+            internal_execute(worker, &j);
+            continue;
+        }
+
+        if (!idle_start) idle_start = thread_clock_ns();
+        thread_yield();
+    }
+
+    if (worker && idle_start && worker->depth == 0) {
+        atomic_add_i64(&worker->idle_ns, (i64)(thread_clock_ns() - idle_start));
+    }
+}
+
+void job_system_parallel_for(u32 count, u32 grain_size, job_range_fn fn, void* data) {
+    if (count == 0) return;
+
+    if (grain_size == 0) {
+        // A few ranges per thread so stealing can even out uneven ranges
+        grain_size = count / (job_system_thread_count() * 4);
+        if (grain_size == 0) grain_size = 1;
+    }
+
+    if (grain_size >= count || !internal_current_worker()) {
+        fn(data, 0, count);
+        return;
+    }
+
+    job_counter counter = { 0 };
+    for (u32 begin = 0; begin < count; begin += grain_size) {
+        u32 end = count - begin > grain_size ? begin + grain_size : count;
+        job_system_submit_range(fn, data, begin, end, &counter);
+    }
+
+    job_system_wait(&counter);
+}
+
+void job_system_get_stats(u32 thread_index, job_worker_stats* out_stats) {
+    memset(out_stats, 0, sizeof(job_worker_stats));
+    if (!jobs.initialized || thread_index >= jobs.thread_count) return;
+
+    job_worker* worker = jobs.workers[thread_index];
+    out_stats->jobs_executed = (u64)atomic_load_i64(&worker->jobs_executed);
+    out_stats->jobs_stolen = (u64)atomic_load_i64(&worker->jobs_stolen);
+    out_stats->busy_ns = (u64)atomic_load_i64(&worker->busy_ns);
+    out_stats->idle_ns = (u64)atomic_load_i64(&worker->idle_ns);
+}
+
+void job_system_reset_stats() {
+    for (u32 i = 0; i < jobs.thread_count; i++) {
+        job_worker* worker = jobs.workers[i];
+        atomic_store_i64(&worker->jobs_executed, 0);
+        atomic_store_i64(&worker->jobs_stolen, 0);
+        atomic_store_i64(&worker->busy_ns, 0);
+        atomic_store_i64(&worker->idle_ns, 0);
+    }
+}
+
+// -- JOB SYSTEM FUNCTIONS --
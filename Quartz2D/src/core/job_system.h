@@ -0,0 +1,41 @@
+#pragma once
+
+#include <common.h>
+
+// Work-stealing job system. Every thread (the one calling job_system_init plus the workers)
+// owns a Chase-Lev deque: it pushes and pops jobs at the bottom of its own deque while idle
+// threads steal from the top of the others. Dependencies are expressed with job counters.
+
+typedef void (*job_fn)(void* data);
+typedef void (*job_range_fn)(void* data, u32 begin, u32 end);
+
+// Number of jobs still running, a counter must stay alive until job_system_wait returns
+typedef struct {
+    volatile i32 value;
+} job_counter;
+
+typedef struct {
+    u64 jobs_executed;
+    u64 jobs_stolen;
+    u64 busy_ns;  // Time spent inside jobs
+    u64 idle_ns;  // Time spent looking for work or asleep
+} job_worker_stats;
+
+u8 job_system_init(u32 worker_count); // 0 picks one worker per extra core
+void job_system_shutdown();
+
+u32 job_system_thread_count();  // Workers plus the thread that called job_system_init
+u32 job_system_thread_index();  // 0 on the init thread, 1..worker_count on the workers
+
+// Jobs may only be submitted from job system threads (the init thread or inside a job)
+void job_system_submit(job_fn fn, void* data, job_counter* counter);
+void job_system_submit_range(job_range_fn fn, void* data, u32 begin, u32 end, job_counter* counter);
+
+// Runs other jobs until the counter reaches zero
+void job_system_wait(job_counter* counter);
+
+// Splits [0, count) into ranges of grain_size (0 picks one) and waits for all of them
+void job_system_parallel_for(u32 count, u32 grain_size, job_range_fn fn, void* data);
+
+void job_system_get_stats(u32 thread_index, job_worker_stats* out_stats);
+void job_system_reset_stats();
@@ -0,0 +1,56 @@
+#include <core/radix_sort.h>
+
+#include <string.h>
+
+void radix_sort_u64(u64* keys, u32* values, u64* temp_keys, u32* temp_values, u32 count) {
+    if (count < 2) return;
+
+    // Histograms of all 8 bytes are built in a single read of the keys
+    u32 histograms[8][256];
+    memset(histograms, 0, sizeof(histograms));
+
+    for (u32 i = 0; i < count; i++) {
+        u64 key = keys[i];
+        for (u32 pass = 0; pass < 8; pass++) {
+            histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+        }
+    }
+
+    u64* src_keys = keys;
+    u32* src_values = values;
+    u64* dst_keys = temp_keys;
+    u32* dst_values = temp_values;
+
+    for (u32 pass = 0; pass < 8; pass++) {
+        u32* histogram = histograms[pass];
+        u32 shift = pass * 8;
+
+        if (histogram[(src_keys[0] >> shift) & 0xFF] == count) continue; // Every key has the same byte
+
+        u32 offset = 0;
+        for (u32 b = 0; b < 256; b++) {
+            u32 bucket_count = histogram[b];
+            histogram[b] = offset;
+            offset += bucket_count;
+        }
+
+        for (u32 i = 0; i < count; i++) {
+            u32 index = histogram[(src_keys[i] >> shift) & 0xFF]++;
+            dst_keys[index] = src_keys[i];
+            dst_values[index] = src_values[i];
+        }
+
+        u64* swap_keys = src_keys;
+        src_keys = dst_keys;
+        dst_keys = swap_keys;
+
+        u32* swap_values = src_values;
+        src_values = dst_values;
+        dst_values = swap_values;
+    }
+
+    if (src_keys != keys) {
+        memcpy(keys, src_keys, sizeof(u64) * count);
+        memcpy(values, src_values, sizeof(u32) * count);
+    }
+}
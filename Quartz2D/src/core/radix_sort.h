@@ -0,0 +1,14 @@
+#pragma once
+
+#include <common.h>
+
+// Stable LSD radix sort of 64 bit keys, 8 bits per pass, values are moved along with their keys.
+// The temp arrays must hold count elements, the sorted result always ends up in keys / values.
+// Passes where every key has the same byte are skipped, so keys with few distinct bits sort fast.
+void radix_sort_u64(u64* keys, u32* values, u64* temp_keys, u32* temp_values, u32 count);
+
+// Maps a float to a u32 that sorts in the same order (negative values included)
+static __inline u32 radix_sort_float_key(f32 value) {
+    union { f32 f; u32 u; } bits = { value };
+    return (bits.u & 0x80000000u) ? ~bits.u : (bits.u | 0x80000000u);
+}
@@ -1,4 +1,5 @@
 #include <scripts.h>
+#include <ECS/physics.h>
 #include <renderer/renderer2D.h>
 #include <platform/platform.h>
 
@@ -6,24 +7,37 @@ extern const int WIDTH = 1280;
 extern const int HEIGHT = 720;
 extern const int UPSCALE_MULTIPLIER = 4;
 
-// Custom component for blasts
-typedef struct {
-	f32 speed; // Units per second
-} blast_component;
+void draw_blasts(const ecs_system_context* ctx) {
+	const transform_component* transforms = ecs_iter_transforms(ctx->span);
 
-void draw_blasts(entity_id id, u32 index) {
-	transform_component* t = entity_get_transform(id);
-	renderer2D_draw_quad(t->x, t->y, 8, 16, -1, (color4) { 1.0f, 1.0f, 1.0f, 1.0f }, t->z); // Or draw with texture
+	for (u32 i = 0; i < ctx->span->count; i++) {
+		const transform_component* t = &transforms[i];
+		renderer2D_draw_quad(t->x, t->y, 8, 16, -1, (color4) { 1.0f, 1.0f, 1.0f, 1.0f }, t->z); // Or draw with texture
+	}
 }
 
-void blast_on_update(entity_id entity, f32 delta_time) {
-	transform_component* t = entity_get_transform(entity);
-	blast_component* b = entity_get_custom(entity, blast_component);
+void cull_blasts(const ecs_system_context* ctx) {
+	const transform_component* transforms = ecs_iter_transforms(ctx->span);
+
+	for (u32 i = 0; i < ctx->span->count; i++) {
+		if (transforms[i].y > HEIGHT) {
+			ecs_command_buffer_destroy_entity(ctx->commands, ctx->span->entities[i]); // Off-screen, delete
+		}
+	}
+}
 
-	t->y += b->speed * delta_time;
+void update_collisions(const ecs_system_context* ctx) {
+	ecs_broadphase_update((ecs_broadphase*)ctx->user_data);
+}
+
+void resolve_blast_hits(const ecs_system_context* ctx) {
+	u32 pair_count = 0;
+	const collision_pair* pairs = ecs_broadphase_get_pairs((const ecs_broadphase*)ctx->user_data, &pair_count);
 
-	if (t->y > HEIGHT) {
-		entity_destroy(entity); // Off-screen, delete
+	for (u32 i = 0; i < pair_count; i++) {
+		// Layer masks only let blasts touch enemies, so one side of every pair is the blast
+		entity_id blast = entity_get_collider(pairs[i].a)->layer & COLLISION_LAYER_BLAST ? pairs[i].a : pairs[i].b;
+		ecs_command_buffer_destroy_entity(ctx->commands, blast);
 	}
 }
 
@@ -50,14 +64,21 @@ void my_script_on_update(entity_id entity, f32 delta_time) {
 			.z = 1.0f,
 		};
 
-		blast_component blast_c = {
-			.speed = 1000.0f // Move up fast
+		rigidbody_component blast_body = {
+			.velocity_y = 1000.0f // Move up fast
 		};
 
-		entity_add_component(blast, &blast_t, ENTITY_COMPONENT_TRANSFORM);
-		entity_add_component(blast, (custom_component*)&blast_c, ENTITY_COMPONENT_CUSTOM);
+		collider_component blast_collider = {
+			.shape = COLLIDER_SHAPE_AABB,
+			.layer = COLLISION_LAYER_BLAST,
+			.mask = COLLISION_LAYER_ENEMY,
+			.half_width = 4.0f,
+			.half_height = 8.0f
+		};
 
-		REGISTER_SCRIPT(blast, NULL, blast_on_update, NULL);
+		entity_add_component(blast, &blast_t, ENTITY_COMPONENT_TRANSFORM);
+		entity_add_component(blast, &blast_body, ENTITY_COMPONENT_RIGIDBODY);
+		entity_add_component(blast, &blast_collider, ENTITY_COMPONENT_COLLIDER);
 
 		shoot_cooldown = 0.1f;
 	}
@@ -0,0 +1,251 @@
+#if !defined(_WIN64) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L // clock_gettime when built as plain C11
+#endif
+
+#include <core/thread.h>
+
+#include <stdlib.h>
+
+typedef struct {
+    thread_fn fn;
+    void* arg;
+} thread_start;
+
+#ifdef _WIN64
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+typedef struct {
+    HANDLE handle;
+} win32_thread;
+
+static DWORD WINAPI thread_entry(LPVOID param) {
+    thread_start start = *(thread_start*)param;
+    free(param);
+
+    start.fn(start.arg);
+    return 0;
+}
+
+u8 thread_create(thread* t, thread_fn fn, void* arg) {
+    thread_start* start = (thread_start*)malloc(sizeof(thread_start));
+    if (!start) return false;
+
+    start->fn = fn;
+    start->arg = arg;
+
+    HANDLE handle = CreateThread(NULL, 0, thread_entry, start, 0, NULL);
+    if (!handle) {
+        free(start);
+        return false;
+    }
+
+    t->internal = handle;
+    return true;
+}
+
+void thread_join(thread* t) {
+    if (!t->internal) return;
+
+    WaitForSingleObject((HANDLE)t->internal, INFINITE);
+    CloseHandle((HANDLE)t->internal);
+    t->internal = NULL;
+}
+
+void thread_yield() {
+    SwitchToThread();
+}
+
+u32 thread_hardware_concurrency() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (u32)info.dwNumberOfProcessors;
+}
+
+u64 thread_clock_ns() {
+    static LARGE_INTEGER frequency = { 0 };
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (u64)((f64)now.QuadPart * 1000000000.0 / (f64)frequency.QuadPart);
+}
+
+u8 mutex_create(mutex* m) {
+    SRWLOCK* lock = (SRWLOCK*)malloc(sizeof(SRWLOCK));
+    if (!lock) return false;
+
+    InitializeSRWLock(lock);
+    m->internal = lock;
+    return true;
+}
+
+void mutex_destroy(mutex* m) {
+    if (m->internal) {
+        free(m->internal);
+        m->internal = NULL;
+    }
+}
+
+void mutex_lock(mutex* m) {
+    AcquireSRWLockExclusive((SRWLOCK*)m->internal);
+}
+
+void mutex_unlock(mutex* m) {
+    ReleaseSRWLockExclusive((SRWLOCK*)m->internal);
+}
+
+u8 condition_create(condition* c) {
+    CONDITION_VARIABLE* cv = (CONDITION_VARIABLE*)malloc(sizeof(CONDITION_VARIABLE));
+    if (!cv) return false;
+
+    InitializeConditionVariable(cv);
+    c->internal = cv;
+    return true;
+}
+
+void condition_destroy(condition* c) {
+    if (c->internal) {
+        free(c->internal);
+        c->internal = NULL;
+    }
+}
+
+void condition_wait(condition* c, mutex* m) {
+    SleepConditionVariableSRW((CONDITION_VARIABLE*)c->internal, (SRWLOCK*)m->internal, INFINITE, 0);
+}
+
+void condition_signal(condition* c) {
+    WakeConditionVariable((CONDITION_VARIABLE*)c->internal);
+}
+
+void condition_broadcast(condition* c) {
+    WakeAllConditionVariable((CONDITION_VARIABLE*)c->internal);
+}
+
+#else // pthreads
+
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+static void* thread_entry(void* param) {
+    thread_start start = *(thread_start*)param;
+    free(param);
+
+    start.fn(start.arg);
+    return NULL;
+}
+
+u8 thread_create(thread* t, thread_fn fn, void* arg) {
+    thread_start* start = (thread_start*)malloc(sizeof(thread_start));
+    pthread_t* handle = (pthread_t*)malloc(sizeof(pthread_t));
+    if (!start || !handle) {
+        free(start);
+        free(handle);
+        return false;
+    }
+
+    start->fn = fn;
+    start->arg = arg;
+
+    if (pthread_create(handle, NULL, thread_entry, start) != 0) {
+        free(start);
+        free(handle);
+        return false;
+    }
+
+    t->internal = handle;
+    return true;
+}
+
+void thread_join(thread* t) {
+    if (!t->internal) return;
+
+    pthread_join(*(pthread_t*)t->internal, NULL);
+    free(t->internal);
+    t->internal = NULL;
+}
+
+void thread_yield() {
+    sched_yield();
+}
+
+u32 thread_hardware_concurrency() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (u32)count : 1;
+}
+
+u64 thread_clock_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000ULL + (u64)now.tv_nsec;
+}
+
+u8 mutex_create(mutex* m) {
+    pthread_mutex_t* lock = (pthread_mutex_t*)malloc(sizeof(pthread_mutex_t));
+    if (!lock) return false;
+
+    if (pthread_mutex_init(lock, NULL) != 0) {
+        free(lock);
+        return false;
+    }
+
+    m->internal = lock;
+    return true;
+}
+
+void mutex_destroy(mutex* m) {
+    if (m->internal) {
+        pthread_mutex_destroy((pthread_mutex_t*)m->internal);
+        free(m->internal);
+        m->internal = NULL;
+    }
+}
+
+void mutex_lock(mutex* m) {
+    pthread_mutex_lock((pthread_mutex_t*)m->internal);
+}
+
+void mutex_unlock(mutex* m) {
+    pthread_mutex_unlock((pthread_mutex_t*)m->internal);
+}
+
+u8 condition_create(condition* c) {
+    pthread_cond_t* cv = (pthread_cond_t*)malloc(sizeof(pthread_cond_t));
+    if (!cv) return false;
+
+    if (pthread_cond_init(cv, NULL) != 0) {
+        free(cv);
+        return false;
+    }
+
+    c->internal = cv;
+    return true;
+}
+
+void condition_destroy(condition* c) {
+    if (c->internal) {
+        pthread_cond_destroy((pthread_cond_t*)c->internal);
+        free(c->internal);
+        c->internal = NULL;
+    }
+}
+
+void condition_wait(condition* c, mutex* m) {
+    pthread_cond_wait((pthread_cond_t*)c->internal, (pthread_mutex_t*)m->internal);
+}
+
+void condition_signal(condition* c) {
+    pthread_cond_signal((pthread_cond_t*)c->internal);
+}
+
+void condition_broadcast(condition* c) {
+    pthread_cond_broadcast((pthread_cond_t*)c->internal);
+}
+
+#endif // _WIN64
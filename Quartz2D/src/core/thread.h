@@ -0,0 +1,42 @@
+#pragma once
+
+#include <common.h>
+
+// Thin wrapper over the platform threading primitives (Win32 or pthreads)
+
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+typedef void (*thread_fn)(void* arg);
+
+typedef struct {
+    void* internal;
+} thread;
+
+typedef struct {
+    void* internal;
+} mutex;
+
+typedef struct {
+    void* internal;
+} condition;
+
+u8 thread_create(thread* t, thread_fn fn, void* arg);
+void thread_join(thread* t);
+void thread_yield();
+u32 thread_hardware_concurrency();
+u64 thread_clock_ns(); // Monotonic clock for profiling threads
+
+u8 mutex_create(mutex* m);
+void mutex_destroy(mutex* m);
+void mutex_lock(mutex* m);
+void mutex_unlock(mutex* m);
+
+u8 condition_create(condition* c);
+void condition_destroy(condition* c);
+void condition_wait(condition* c, mutex* m);
+void condition_signal(condition* c);
+void condition_broadcast(condition* c);
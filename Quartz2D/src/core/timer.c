@@ -1,5 +1,11 @@
+#if !defined(_WIN64) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L // clock_gettime
+#endif
+
 #include <core/timer.h>
 
+#ifdef _WIN64
+
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 
@@ -19,4 +25,32 @@ void timer_end(timer* t) {
 
     float elapsed_sec = (float)((now.QuadPart - t->start_time) / (double)t->qpc_frequency);
     t->delta_time = elapsed_sec;
-}
\ No newline at end of file
+}
+
+#else
+
+#include <time.h>
+
+// Monotonic nanoseconds, the frequency is fixed at one tick per nanosecond
+static long long internal_now_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+void timer_init(timer* t) {
+    t->qpc_frequency = 1000000000LL;
+    t->start_time = internal_now_ns();
+    t->delta_time = 0.0167f;  // Default assumption ~60fps
+}
+
+void timer_begin(timer* t) {
+    t->start_time = internal_now_ns();
+}
+
+void timer_end(timer* t) {
+    float elapsed_sec = (float)((internal_now_ns() - t->start_time) / (double)t->qpc_frequency);
+    t->delta_time = elapsed_sec;
+}
+
+#endif // _WIN64
@@ -3,7 +3,7 @@
 #include <common.h>
 
 typedef struct {
-    long long qpc_frequency;
+    long long qpc_frequency;  // Ticks per second, QueryPerformanceFrequency on Windows and nanoseconds elsewhere
     long long start_time;
 
     float delta_time;  // time in seconds for this frame
@@ -1,12 +1,37 @@
 #include <platform/platform.h>
 #include <renderer/renderer2D.h>
+#include <renderer/renderer2D_bench.h>
+#include <renderer/frame_capture.h>
 #include <asset_loader/asset_loader.h>
 #include <ECS/ecs.h>
+#include <ECS/scheduler.h>
+#include <ECS/physics.h>
 #include <core/timer.h>
+#include <core/job_system.h>
 #include <scripts.h>
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _MSC_VER
 #include <crtdbg.h>
+#endif
+
+static u8 has_argument(int argc, char* argv[], const char* name) {
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], name) == 0) return true;
+	}
+	return false;
+}
+
+// The argument after name, NULL if name isn't given
+static const char* argument_value(int argc, char* argv[], const char* name) {
+	for (int i = 1; i + 1 < argc; i++) {
+		if (strcmp(argv[i], name) == 0) return argv[i + 1];
+	}
+	return NULL;
+}
 
 int main(int argc, char* argv[]) {
 	// Setup window, per-platform
@@ -21,16 +46,148 @@ int main(int argc, char* argv[]) {
 		return -1;
 	}
 
-	// Initialize the 2D renderer
-	if (!renderer2D_init(WIDTH, HEIGHT)) {
+	// --input replays a key script, --record-input writes the keys pressed to one
+	const char* input_path = argument_value(argc, argv, "--input");
+	if (input_path && !platform_load_input_script(input_path)) {
+		printf("Failed to load input script %s!\n", input_path);
+		return -1;
+	}
+
+	const char* record_path = argument_value(argc, argv, "--record-input");
+	if (record_path && !platform_record_input(record_path)) {
+		printf("Failed to record input to %s!\n", record_path);
+		return -1;
+	}
+
+	// Initialize the 2D renderer, --software rasterizes on the CPU instead of the GPU
+#ifdef QUARTZ_PLATFORM_HEADLESS
+	renderer2D_backend backend = RENDERER2D_BACKEND_SOFTWARE; // There is no GL context without a window
+#else
+	renderer2D_backend backend = has_argument(argc, argv, "--software") ? RENDERER2D_BACKEND_SOFTWARE : RENDERER2D_BACKEND_OPENGL;
+#endif
+	if (!renderer2D_init_backend(WIDTH, HEIGHT, backend)) {
 		printf("Failed to initialize renderer2D!\n");
 		return -1;
 	}
 
+	// --pixel-art draws the scene at the resolution of the art and upscales it, a texel is UPSCALE_MULTIPLIER pixels wide
+	if (has_argument(argc, argv, "--pixel-art") && !renderer2D_set_pixel_scale(UPSCALE_MULTIPLIER)) {
+		printf("Failed to create the pixel art target!\n");
+		return -1;
+	}
+
+	// Draw calls are sorted by depth and texture at the end of the frame, whatever order they come in
+	renderer2D_set_deferred(true);
+
+	// One worker per extra core, this thread runs jobs too while it waits on them
+	if (!job_system_init(0)) {
+		printf("Failed to initialize the job system!\n");
+		return -1;
+	}
+
+	// --bench measures the renderer on its own and exits
+	if (has_argument(argc, argv, "--bench")) {
+		platform_set_vsync(false);
+		i32 result = renderer2D_bench_run(WIDTH, HEIGHT, 100000, 200);
+
+		job_system_shutdown();
+		renderer2D_shutdown();
+		platform_shutdown();
+		return result;
+	}
+
+	// --replay plays a frame capture through the renderer without the game and exits
+	const char* replay_path = argument_value(argc, argv, "--replay");
+	if (replay_path) {
+		platform_set_vsync(false);
+		i32 result = frame_capture_replay(replay_path, 3);
+
+		job_system_shutdown();
+		renderer2D_shutdown();
+		platform_shutdown();
+		return result;
+	}
+
+	// --capture writes the draw calls of the first frames to a file, --capture-frames sets how many
+	const char* capture_path = argument_value(argc, argv, "--capture");
+	if (capture_path) {
+		const char* frames = argument_value(argc, argv, "--capture-frames");
+		if (!renderer2D_capture_frames(capture_path, frames ? (u32)strtoul(frames, NULL, 10) : 300)) {
+			printf("Failed to capture frames to %s!\n", capture_path);
+			return -1;
+		}
+	}
+
 	// -- ECS --
 
 	ecs_init();
 
+	// Systems declare what they touch, the scheduler runs the ones that don't conflict in parallel
+	ecs_scheduler* scheduler = ecs_scheduler_create();
+	if (!scheduler) {
+		printf("Failed to create the ECS scheduler!\n");
+		return -1;
+	}
+	ecs_scheduler_add_builtin_systems(scheduler);
+
+	{
+		// Blasts are the only bodies without a sprite, they move through the rigidbody integration
+		ecs_system_desc cull = {
+			.name = "cull_blasts",
+			.reads = ENTITY_COMPONENT_TRANSFORM,
+			.with = ENTITY_COMPONENT_TRANSFORM | ENTITY_COMPONENT_RIGIDBODY,
+			.without = ENTITY_COMPONENT_SPRITE,
+			.flags = ECS_SYSTEM_PARALLEL,
+			.run = cull_blasts
+		};
+		ecs_scheduler_add_system(scheduler, &cull);
+
+		ecs_system_desc blasts = {
+			.name = "draw_blasts",
+			.reads = ENTITY_COMPONENT_TRANSFORM,
+			.with = ENTITY_COMPONENT_TRANSFORM | ENTITY_COMPONENT_RIGIDBODY,
+			.without = ENTITY_COMPONENT_SPRITE,
+			.flags = ECS_SYSTEM_MAIN_THREAD,
+			.run = draw_blasts
+		};
+		ecs_scheduler_add_system(scheduler, &blasts);
+	}
+
+	// Broadphase cells about the size of a ship
+	ecs_broadphase* broadphase = ecs_broadphase_create(16.0f * UPSCALE_MULTIPLIER);
+
+	{
+		// Both run on the main thread so the pairs are consumed right after they are found
+		ecs_system_desc collisions = {
+			.name = "update_collisions",
+			.reads = ENTITY_COMPONENT_TRANSFORM | ENTITY_COMPONENT_COLLIDER,
+			.flags = ECS_SYSTEM_MAIN_THREAD,
+			.run = update_collisions,
+			.user_data = broadphase
+		};
+		ecs_scheduler_add_system(scheduler, &collisions);
+
+		ecs_system_desc hits = {
+			.name = "resolve_blast_hits",
+			.reads = ENTITY_COMPONENT_COLLIDER,
+			.flags = ECS_SYSTEM_MAIN_THREAD,
+			.run = resolve_blast_hits,
+			.user_data = broadphase
+		};
+		ecs_scheduler_add_system(scheduler, &hits);
+	}
+
+	// Both ships loop the same frames, the animation must outlive the sprites that point at it
+	f32 animation_rate = 50.0f / 1000.0f;
+
+	sprite_animation ship_fly = {
+		.frames = (animation_frame[]) {
+			{ 0, animation_rate }, { 1, animation_rate }, { 2, animation_rate }, { 3, animation_rate } // Looping cycle
+		},
+		.frame_count = 4,
+		.looping = true
+	};
+
 	entity_id player_id = entity_create();
 
 	// Player entity
@@ -45,16 +202,6 @@ int main(int argc, char* argv[]) {
 		entity_add_component(player_id, &t, ENTITY_COMPONENT_TRANSFORM);
 
 		// Set up an animated sprite
-		f32 animation_rate = 50.0f / 1000.0f;
-
-		sprite_animation ship_fly = {
-			.frames = (animation_frame[]) {
-				{ 0, animation_rate }, { 1, animation_rate }, { 2, animation_rate }, { 3, animation_rate } // Looping cycle
-			},
-			.frame_count = 4,
-			.looping = true
-		};
-
 		animation_state ship_anim = {
 			.animation = &ship_fly,
 			.current_frame = 0,
@@ -91,16 +238,6 @@ int main(int argc, char* argv[]) {
 		entity_add_component(enemy_id, &t, ENTITY_COMPONENT_TRANSFORM);
 
 		// Set up an animated sprite
-		f32 animation_rate = 50.0f / 1000.0f;
-
-		sprite_animation ship_fly = {
-			.frames = (animation_frame[]) {
-				{ 0, animation_rate }, { 1, animation_rate }, { 2, animation_rate }, { 3, animation_rate } // Looping cycle
-			},
-			.frame_count = 4,
-			.looping = true
-		};
-
 		animation_state ship_anim = {
 			.animation = &ship_fly,
 			.current_frame = 0,
@@ -120,13 +257,25 @@ int main(int argc, char* argv[]) {
 		};
 
 		entity_add_component(enemy_id, &s, ENTITY_COMPONENT_SPRITE);
+
+		collider_component c = {
+			.shape = COLLIDER_SHAPE_AABB,
+			.layer = COLLISION_LAYER_ENEMY,
+			.mask = COLLISION_LAYER_BLAST,
+			.half_width = s.width / 2.0f,
+			.half_height = s.height / 2.0f
+		};
+
+		entity_add_component(enemy_id, &c, ENTITY_COMPONENT_COLLIDER);
 	}
 	
 	entity_id hearts[5] = { 0 };
 
 	{
+		// The hearts never move, they are drawn from a retained batch
 		sprite_component heart_sprite = {
 			.is_animated = false,
+			.is_static = true,
 			.width = 16 * UPSCALE_MULTIPLIER,
 			.height = 16 * UPSCALE_MULTIPLIER,
 			.texture_id = asset_loader_load_texture_from_tga("heart.tga")
@@ -159,6 +308,9 @@ int main(int argc, char* argv[]) {
 		.kerning = 0.8f
 	};
 
+	// Glyph uvs and advances are computed once here instead of per character every frame
+	bitmap_font_build_glyphs(&en_font);
+
 	ecs_initialize_scripts();
 
 	// -- ECS --
@@ -170,15 +322,11 @@ int main(int argc, char* argv[]) {
 
 		// This will be updated at the end of the frame
 		platform_pump_messages();
-		ecs_update_scripts(time.delta_time);
-		ecs_update_sprite_animations(time.delta_time);
 
-		renderer2D_begin_batch();
+		renderer2D_begin_frame();
 		renderer2D_draw_bitmap_text(50.0f, 80.0f, 24.0f, "Player one Start", &en_font, (color4) { 1, 1, 1, 1 }, 0.0f);
-		ecs_draw_sprites();
-		ecs_for_each(ENTITY_COMPONENT_CUSTOM, draw_blasts);
-		renderer2D_end_batch();
-		renderer2D_flush();
+		ecs_scheduler_run(scheduler, time.delta_time); // Scripts, physics and animations, drawing, then collisions
+		renderer2D_end_frame();
 
 		timer_end(&time);
 	}
@@ -196,13 +344,19 @@ int main(int argc, char* argv[]) {
 	entity_destroy(player_id);
 
 	ecs_shutdown_scripts();
+	ecs_scheduler_destroy(scheduler);
+	ecs_broadphase_destroy(broadphase);
 	ecs_shutdown();
 
+	job_system_shutdown();
+
 	renderer2D_shutdown();
 
 	platform_shutdown();
 
+#ifdef _MSC_VER
 	_CrtDumpMemoryLeaks();
+#endif
 
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,150 @@
+#include <platform/input/input_script.h>
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// -- INTERNAL STRUCTURES --
+
+typedef struct {
+    const char* name;
+    size_t offset;
+} input_key;
+
+#define INPUT_KEY(field) { #field, offsetof(keys, field) }
+
+static const input_key key_table[] = {
+    INPUT_KEY(up), INPUT_KEY(down), INPUT_KEY(left), INPUT_KEY(right),
+    INPUT_KEY(w), INPUT_KEY(a), INPUT_KEY(s), INPUT_KEY(d),
+    INPUT_KEY(space), INPUT_KEY(enter), INPUT_KEY(shift), INPUT_KEY(ctrl), INPUT_KEY(alt),
+    INPUT_KEY(esc), INPUT_KEY(tab), INPUT_KEY(backspace),
+    INPUT_KEY(q), INPUT_KEY(e), INPUT_KEY(r), INPUT_KEY(f),
+    INPUT_KEY(z), INPUT_KEY(x), INPUT_KEY(c), INPUT_KEY(v),
+    INPUT_KEY(one), INPUT_KEY(two), INPUT_KEY(three), INPUT_KEY(four),
+    INPUT_KEY(five), INPUT_KEY(six), INPUT_KEY(seven), INPUT_KEY(eight),
+    INPUT_KEY(nine), INPUT_KEY(zero)
+};
+
+#define INPUT_KEY_COUNT (sizeof(key_table) / sizeof(key_table[0]))
+
+// -- INTERNAL STRUCTURES --
+
+// -- INTERNAL FUNCTIONS --
+
+static i32 internal_find_key(const char* name) {
+    for (u32 i = 0; i < INPUT_KEY_COUNT; i++) {
+        if (strcmp(key_table[i].name, name) == 0) return (i32)i;
+    }
+    return -1;
+}
+
+static u8 internal_push_event(input_script* script, u64 frame, i32 key, u8 down) {
+    if (script->count == script->capacity) {
+        u32 new_capacity = script->capacity ? script->capacity * 2 : 64;
+        input_event* events = (input_event*)realloc(script->events, sizeof(input_event) * new_capacity);
+        if (!events) return false;
+
+        script->events = events;
+        script->capacity = new_capacity;
+    }
+
+    script->events[script->count++] = (input_event){ frame, key, down };
+    return true;
+}
+
+// -- INTERNAL FUNCTIONS --
+
+// -- INPUT SCRIPT FUNCTIONS --
+
+u8 input_script_load(input_script* script, const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) return false;
+
+    free(script->events);
+    script->events = NULL;
+    script->count = 0;
+    script->capacity = 0;
+    script->next = 0;
+
+    char line[128];
+    u8 ok = true;
+
+    while (ok && fgets(line, sizeof(line), file)) {
+        unsigned long long frame = 0;
+        char key[32];
+        char state[8];
+
+        i32 fields = sscanf(line, "%llu %31s %7s", &frame, key, state);
+        if (fields <= 0 || line[0] == '#') continue; // Blank line or comment
+
+        if (script->count > 0 && frame < script->events[script->count - 1].frame) {
+            ok = false; // Out of order
+        }
+        else if (fields == 2 && strcmp(key, "quit") == 0) {
+            ok = internal_push_event(script, frame, INPUT_SCRIPT_QUIT, false);
+        }
+        else if (fields == 3 && internal_find_key(key) >= 0 && (strcmp(state, "down") == 0 || strcmp(state, "up") == 0)) {
+            ok = internal_push_event(script, frame, internal_find_key(key), strcmp(state, "down") == 0);
+        }
+        else {
+            ok = false;
+        }
+    }
+
+    fclose(file);
+
+    if (!ok) {
+        free(script->events);
+        script->events = NULL;
+        script->count = 0;
+        script->capacity = 0;
+    }
+
+    return ok;
+}
+
+void input_script_free(input_script* script) {
+    if (script->record) fclose(script->record);
+    free(script->events);
+    memset(script, 0, sizeof(input_script));
+}
+
+u8 input_script_apply(input_script* script, u64 frame, keys* k) {
+    for (; script->next < script->count && script->events[script->next].frame <= frame; script->next++) {
+        const input_event* event = &script->events[script->next];
+        if (event->key == INPUT_SCRIPT_QUIT) return false;
+
+        *((u8*)k + key_table[event->key].offset) = event->down;
+    }
+
+    return true;
+}
+
+u8 input_script_record(input_script* script, const char* path) {
+    if (script->record) fclose(script->record);
+
+    script->record = fopen(path, "w");
+    return script->record != NULL;
+}
+
+void input_script_record_key(input_script* script, u64 frame, const keys* k, const u8* key_state, u8 down) {
+    if (!script->record) return;
+
+    size_t offset = (size_t)(key_state - (const u8*)k);
+    for (u32 i = 0; i < INPUT_KEY_COUNT; i++) {
+        if (key_table[i].offset == offset) {
+            fprintf(script->record, "%llu %s %s\n", (unsigned long long)frame, key_table[i].name, down ? "down" : "up");
+            return;
+        }
+    }
+}
+
+void input_script_record_quit(input_script* script, u64 frame) {
+    if (!script->record) return;
+
+    fprintf(script->record, "%llu quit\n", (unsigned long long)frame);
+    fclose(script->record);
+    script->record = NULL;
+}
+
+// -- INPUT SCRIPT FUNCTIONS --
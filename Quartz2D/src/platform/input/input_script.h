@@ -0,0 +1,38 @@
+#pragma once
+
+#include <common.h>
+#include <platform/input/input.h>
+
+#include <stdio.h>
+
+// Key presses by frame, so a run can be replayed without anyone at the keyboard. Scripts are text with
+// one event per line, in frame order: "<frame> <key> down", "<frame> <key> up" or "<frame> quit". Keys are
+// named like the fields of keys ("space", "left", "one"...), lines starting with # are comments.
+// Frame n is the n-th call to platform_pump_messages, counting from 0.
+
+#define INPUT_SCRIPT_QUIT -1 // Key of the event that ends the run
+
+typedef struct {
+    u64 frame;
+    i32 key;  // Index into the key table, INPUT_SCRIPT_QUIT to stop
+    u8 down;
+} input_event;
+
+typedef struct {
+    input_event* events;
+    u32 count;
+    u32 capacity;
+    u32 next;       // First event not applied yet
+    FILE* record;   // Key changes are written here while recording, NULL otherwise
+} input_script;
+
+// False if the file can't be read or a line doesn't parse, the script is left empty
+u8 input_script_load(input_script* script, const char* path);
+void input_script_free(input_script* script);
+
+// Applies the events up to frame to the key state, false once the quit event is reached
+u8 input_script_apply(input_script* script, u64 frame, keys* k);
+
+u8 input_script_record(input_script* script, const char* path);
+void input_script_record_key(input_script* script, u64 frame, const keys* k, const u8* key_state, u8 down); // key_state points into k
+void input_script_record_quit(input_script* script, u64 frame); // Ends the recording, replaying it stops on the same frame
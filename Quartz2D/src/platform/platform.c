@@ -1,6 +1,7 @@
 #include <platform/platform.h>
+#include <platform/input/input_script.h>
 
-#ifdef _WIN64
+#ifndef QUARTZ_PLATFORM_HEADLESS
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -20,6 +21,8 @@ LARGE_INTEGER qpc_frequency;
 LPCSTR class_name = "Quartz2DWindowClass";
 keys keyboard;
 u8 running = true;
+input_script script;
+u64 frame_index; // Calls to platform_pump_messages so far
 
 u8* get_key_state_ptr(keys* k, WPARAM key) {
     switch (key) {
@@ -77,13 +80,19 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
 
         case WM_KEYDOWN: {
             u8* keyPtr = get_key_state_ptr(&keyboard, wParam);
-            if (keyPtr) *keyPtr = true;
+            if (keyPtr && !*keyPtr) {
+                *keyPtr = true;
+                input_script_record_key(&script, frame_index, &keyboard, keyPtr, true); // Repeats aren't recorded
+            }
             break;
         }
 
         case WM_KEYUP: {
             u8* keyPtr = get_key_state_ptr(&keyboard, wParam);
-            if (keyPtr) *keyPtr = false;
+            if (keyPtr && *keyPtr) {
+                *keyPtr = false;
+                input_script_record_key(&script, frame_index, &keyboard, keyPtr, false);
+            }
             break;
         }
     }
@@ -131,7 +140,45 @@ void platform_swap_buffers() {
     SwapBuffers(hDC);
 }
 
+void platform_present_pixels(const u8* rgba, i32 width, i32 height) {
+    static u8* bgra = NULL;
+    static size_t bgra_size = 0;
+
+    // DIBs are BGRA, bottom up like the pixels when the height is positive
+    size_t size = (size_t)width * height * 4;
+    if (size > bgra_size) {
+        u8* resized = (u8*)realloc(bgra, size);
+        if (!resized) return;
+
+        bgra = resized;
+        bgra_size = size;
+    }
+
+    for (size_t i = 0; i < size; i += 4) {
+        bgra[i] = rgba[i + 2];
+        bgra[i + 1] = rgba[i + 1];
+        bgra[i + 2] = rgba[i];
+        bgra[i + 3] = rgba[i + 3];
+    }
+
+    BITMAPINFO info = { 0 };
+    info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    info.bmiHeader.biWidth = width;
+    info.bmiHeader.biHeight = height;
+    info.bmiHeader.biPlanes = 1;
+    info.bmiHeader.biBitCount = 32;
+    info.bmiHeader.biCompression = BI_RGB;
+
+    RECT client;
+    GetClientRect(hWnd, &client);
+    StretchDIBits(hDC, 0, 0, client.right - client.left, client.bottom - client.top, 0, 0, width, height,
+                  bgra, &info, DIB_RGB_COLORS, SRCCOPY);
+}
+
 void platform_shutdown() {
+    input_script_record_quit(&script, frame_index ? frame_index - 1 : 0); // The last frame pumped
+    input_script_free(&script);
+
     wglMakeCurrent(NULL, NULL);
     wglDeleteContext(hRC);
     ReleaseDC(hWnd, hDC);
@@ -143,10 +190,16 @@ u8 platform_should_run() {
 }
 
 void platform_pump_messages() {
+    if (!input_script_apply(&script, frame_index, &keyboard)) {
+        running = false;
+    }
+
     while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
         TranslateMessage(&msg);
         DispatchMessage(&msg);
     }
+
+    frame_index++;
 }
 
 typedef BOOL(WINAPI* PFNWGLSWAPINTERVALEXTPROC)(int interval);
@@ -225,4 +278,12 @@ keys platform_get_keys() {
     return keyboard;
 }
 
-#endif // _WIN64
\ No newline at end of file
+u8 platform_load_input_script(const char* path) {
+    return input_script_load(&script, path);
+}
+
+u8 platform_record_input(const char* path) {
+    return input_script_record(&script, path);
+}
+
+#endif // QUARTZ_PLATFORM_HEADLESS
\ No newline at end of file
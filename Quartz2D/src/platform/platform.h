@@ -2,6 +2,13 @@
 #include <common.h>
 #include <platform/input/input.h>
 
+// Windows opens a window with an OpenGL context. Every other platform, or any build that defines
+// QUARTZ_PLATFORM_HEADLESS, runs headless: no window and no GPU, input only comes from a script and
+// frames are dropped, which is enough for simulation processes and benchmarks.
+#if !defined(_WIN64) && !defined(QUARTZ_PLATFORM_HEADLESS)
+#define QUARTZ_PLATFORM_HEADLESS
+#endif
+
 u8 platform_open_window(i32 width, i32 height);
 void platform_pump_messages();
 void platform_shutdown();
@@ -9,5 +16,11 @@ void platform_sleep_ms(u64 ms);
 f64 platform_get_elapsed_time_ms();
 u8 platform_should_run();
 void platform_swap_buffers();
+void platform_present_pixels(const u8* rgba, i32 width, i32 height); // RGBA8 rows from the bottom, stretched over the window
 keys platform_get_keys();
-u8 platform_set_vsync(u8 sync);
\ No newline at end of file
+u8 platform_set_vsync(u8 sync);
+
+// Key events from a script are applied as their frames are pumped, see input_script.h. A recording
+// captures the keys pressed from then on and ends with a quit on the frame the platform shuts down.
+u8 platform_load_input_script(const char* path);
+u8 platform_record_input(const char* path);
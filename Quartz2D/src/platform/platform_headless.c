@@ -0,0 +1,136 @@
+#if !defined(_WIN64) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L // clock_gettime and nanosleep
+#endif
+
+#include <platform/platform.h>
+#include <platform/input/input_script.h>
+
+#ifdef QUARTZ_PLATFORM_HEADLESS
+
+#include <signal.h>
+#include <string.h>
+
+#ifdef _WIN64
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <errno.h>
+#include <time.h>
+#endif
+
+// -- INTERNAL STRUCTURES --
+
+typedef struct {
+    keys keyboard;
+    input_script script;
+    u64 frame_index;  // Calls to platform_pump_messages so far
+    i32 width, height;
+} headless_platform;
+
+static headless_platform headless;
+static volatile sig_atomic_t running = true; // Cleared by the script's quit or by SIGINT / SIGTERM
+
+// -- INTERNAL STRUCTURES --
+
+// -- INTERNAL FUNCTIONS --
+
+static void internal_on_signal(int signal_number) {
+    (void)signal_number;
+    running = false;
+}
+
+// -- INTERNAL FUNCTIONS --
+
+// -- PLATFORM FUNCTIONS --
+
+u8 platform_open_window(i32 width, i32 height) {
+    memset(&headless, 0, sizeof(headless));
+    headless.width = width;
+    headless.height = height;
+    running = true;
+
+    // A simulation process is stopped like any other
+    signal(SIGINT, internal_on_signal);
+    signal(SIGTERM, internal_on_signal);
+
+    return true;
+}
+
+void platform_pump_messages() {
+    if (!input_script_apply(&headless.script, headless.frame_index, &headless.keyboard)) {
+        running = false;
+    }
+
+    headless.frame_index++;
+}
+
+void platform_shutdown() {
+    input_script_record_quit(&headless.script, headless.frame_index ? headless.frame_index - 1 : 0); // The last frame pumped
+    input_script_free(&headless.script);
+}
+
+#ifdef _WIN64
+
+void platform_sleep_ms(u64 ms) {
+    Sleep((DWORD)ms);
+}
+
+f64 platform_get_elapsed_time_ms() {
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER now;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&now);
+    return ((f64)now.QuadPart * 1000.0) / (f64)frequency.QuadPart;
+}
+
+#else
+
+void platform_sleep_ms(u64 ms) {
+    struct timespec duration = { (time_t)(ms / 1000), (long)(ms % 1000) * 1000000L };
+    while (nanosleep(&duration, &duration) == -1 && errno == EINTR) {
+        // Interrupted by a signal, sleep for the rest
+    }
+}
+
+f64 platform_get_elapsed_time_ms() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (f64)now.tv_sec * 1000.0 + (f64)now.tv_nsec / 1000000.0;
+}
+
+#endif
+
+u8 platform_should_run() {
+    return running != 0;
+}
+
+void platform_swap_buffers() {
+    // Nothing to show the frame on
+}
+
+void platform_present_pixels(const u8* rgba, i32 width, i32 height) {
+    (void)rgba;
+    (void)width;
+    (void)height;
+}
+
+keys platform_get_keys() {
+    return headless.keyboard;
+}
+
+u8 platform_set_vsync(u8 sync) {
+    (void)sync;
+    return true; // No display to wait for, frames run as fast as they are simulated
+}
+
+u8 platform_load_input_script(const char* path) {
+    return input_script_load(&headless.script, path);
+}
+
+u8 platform_record_input(const char* path) {
+    return input_script_record(&headless.script, path);
+}
+
+// -- PLATFORM FUNCTIONS --
+
+#endif // QUARTZ_PLATFORM_HEADLESS
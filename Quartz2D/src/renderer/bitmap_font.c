@@ -0,0 +1,85 @@
+#include <renderer/bitmap_font.h>
+
+// Shared by every font, so a font allocated where a freed one was never matches text cached for the old one
+static u32 glyph_versions = 0;
+
+// -- INTERNAL FUNCTIONS --
+
+static void internal_cell_glyph(const bitmap_font* font, i32 cell, bitmap_glyph* glyph) {
+    i32 col = cell % font->atlas_columns;
+    i32 row = cell / font->atlas_columns;
+
+    f32 glyph_width_uv = 1.0f / (f32)font->atlas_columns;
+    f32 glyph_height_uv = 1.0f / (f32)font->atlas_rows;
+
+    // Rows count from the top, uvs from the bottom
+    glyph->rect.u0 = col * glyph_width_uv;
+    glyph->rect.u1 = glyph->rect.u0 + glyph_width_uv;
+    glyph->rect.v1 = 1.0f - row * glyph_height_uv;
+    glyph->rect.v0 = glyph->rect.v1 - glyph_height_uv;
+    glyph->advance = font->kerning;
+    glyph->visible = true;
+}
+
+static void internal_set_glyph(bitmap_font* font, u8 character, i32 cell) {
+    internal_cell_glyph(font, cell, &font->glyphs[character]);
+}
+
+// What bitmap_font_build_glyphs puts at character, for fonts whose table was never built
+static bitmap_glyph internal_default_glyph(const bitmap_font* font, u8 character) {
+    bitmap_glyph glyph = { { 0.0f, 0.0f, 0.0f, 0.0f }, font->space_width, false };
+    if (font->atlas_columns <= 0 || font->atlas_rows <= 0) return glyph;
+
+    if (character >= 'A' && character <= 'Z') {
+        internal_cell_glyph(font, character - 'A', &glyph);
+    }
+    else if (character >= 'a' && character <= 'z') {
+        internal_cell_glyph(font, 26 + character - 'a', &glyph);
+    }
+    return glyph;
+}
+
+// -- INTERNAL FUNCTIONS --
+
+// -- BITMAP FONT FUNCTIONS --
+
+void bitmap_font_build_glyphs(bitmap_font* font) {
+    for (u32 i = 0; i < BITMAP_FONT_GLYPHS; i++) {
+        bitmap_glyph* glyph = &font->glyphs[i];
+        glyph->rect = (uv_rect){ 0.0f, 0.0f, 0.0f, 0.0f };
+        glyph->advance = font->space_width;
+        glyph->visible = false;
+    }
+
+    if (font->atlas_columns > 0 && font->atlas_rows > 0) {
+        for (i32 i = 0; i < 26; i++) {
+            internal_set_glyph(font, (u8)('A' + i), i);
+            internal_set_glyph(font, (u8)('a' + i), 26 + i);
+        }
+    }
+
+    bitmap_font_glyphs_changed(font);
+}
+
+void bitmap_font_map_glyphs(bitmap_font* font, const char* characters, i32 first_cell) {
+    if (font->atlas_columns <= 0 || font->atlas_rows <= 0) return;
+
+    i32 cell_count = font->atlas_columns * font->atlas_rows;
+    for (i32 i = 0; characters[i] != '\0' && first_cell + i < cell_count; i++) {
+        internal_set_glyph(font, (u8)characters[i], first_cell + i);
+    }
+
+    bitmap_font_glyphs_changed(font);
+}
+
+void bitmap_font_glyphs_changed(bitmap_font* font) {
+    if (++glyph_versions == 0) glyph_versions = 1; // 0 means never built
+    font->glyph_version = glyph_versions;
+}
+
+bitmap_glyph bitmap_font_get_glyph(const bitmap_font* font, u8 character) {
+    if (font->glyph_version == 0) return internal_default_glyph(font, character);
+    return font->glyphs[character];
+}
+
+// -- BITMAP FONT FUNCTIONS --
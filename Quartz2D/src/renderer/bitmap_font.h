@@ -1,6 +1,15 @@
 #pragma once
 
 #include <common.h>
+#include <renderer/texture_atlas.h>
+
+#define BITMAP_FONT_GLYPHS 256 // One glyph per byte value
+
+typedef struct {
+    uv_rect rect;
+    f32 advance;  // Cursor movement in units of the font size
+    u8 visible;   // False for spaces and characters the atlas doesn't have
+} bitmap_glyph;
 
 typedef struct {
     i32 texture_id;
@@ -10,4 +19,21 @@ typedef struct {
     i32 atlas_rows;
     f32 space_width;
     f32 kerning;
-} bitmap_font;
\ No newline at end of file
+
+    // Filled by bitmap_font_build_glyphs, read through bitmap_font_get_glyph
+    bitmap_glyph glyphs[BITMAP_FONT_GLYPHS];
+    u32 glyph_version;  // 0 until the table is built, a new value on every change that no other font has had
+} bitmap_font;
+
+// Maps A-Z then a-z to the first cells of the atlas, everything else advances by space_width.
+// Call once the metrics above are filled in.
+void bitmap_font_build_glyphs(bitmap_font* font);
+
+// Characters take consecutive cells starting at first_cell, row by row from the top of the atlas
+void bitmap_font_map_glyphs(bitmap_font* font, const char* characters, i32 first_cell);
+
+// Gives the font a new glyph version, for code that fills the glyph table itself
+void bitmap_font_glyphs_changed(bitmap_font* font);
+
+// The table entry, or the A-Z then a-z mapping of bitmap_font_build_glyphs while the table was never built
+bitmap_glyph bitmap_font_get_glyph(const bitmap_font* font, u8 character);
@@ -0,0 +1,803 @@
+#include <renderer/frame_capture.h>
+#include <renderer/texture_array.h>
+#include <platform/platform.h>
+
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FRAME_CAPTURE_BUFFER_SIZE (64 * 1024) // Records are gathered here and written in blocks
+#define FRAME_CAPTURE_MAX_TEXTURE_ID (1 << 20) // Larger ids in a capture mean the file is damaged
+#define FRAME_CAPTURE_SPRITE_SIZE 60 // Bytes of a sprite in the file
+
+// -- INTERNAL STRUCTURES --
+
+typedef struct {
+    i32 width;
+    i32 height;
+} captured_texture;
+
+typedef struct {
+    FILE* file;
+    u32 used;
+    u32 frames_left;
+    u8 in_frame;
+
+    captured_texture* textures_seen;  // By texture id, the size last written, zero until then
+    u32 textures_seen_count;
+
+    const bitmap_font* fonts[FRAME_CAPTURE_MAX_FONTS];  // Capture id is the index
+    u32 font_versions[FRAME_CAPTURE_MAX_FONTS];          // Glyph table written for each font
+    u32 font_count;
+
+    const renderer2D_static_batch** batches;  // Capture id is the index, NULL once destroyed
+    u32 batch_count;
+    u32 batch_capacity;
+
+    u8 buffer[FRAME_CAPTURE_BUFFER_SIZE];
+} frame_capture_writer;
+
+static frame_capture_writer writer;
+
+typedef struct {
+    const u8* data;
+    size_t size;
+    size_t offset;
+    u8 failed;  // Read past the end or found a record that doesn't fit the capture
+} capture_reader;
+
+typedef struct {
+    i32* textures;  // Replay texture by captured id, -1 if not created
+    u32 texture_count;
+
+    bitmap_font* fonts;  // FRAME_CAPTURE_MAX_FONTS entries
+    u32 font_count;
+
+    renderer2D_static_batch** batches;
+    u32 batch_count;
+    u32 batch_capacity;
+
+    sprite_instance* sprites;
+    u32 sprite_capacity;
+    char* text;
+    u32 text_capacity;
+} replay_state;
+
+// -- INTERNAL STRUCTURES --
+
+// -- WRITER INTERNAL FUNCTIONS --
+
+static void internal_write(const void* data, u32 size) {
+    if (fwrite(data, 1, size, writer.file) != size) {
+        printf("Failed to write the frame capture, stopping it\n");
+        writer.frames_left = 0; // Closed at the end of the frame
+    }
+}
+
+static void internal_flush_buffer() {
+    if (writer.used == 0) return;
+
+    internal_write(writer.buffer, writer.used);
+    writer.used = 0;
+}
+
+static void internal_put(const void* data, u32 size) {
+    if (writer.used + size > FRAME_CAPTURE_BUFFER_SIZE) {
+        internal_flush_buffer();
+    }
+
+    if (size > FRAME_CAPTURE_BUFFER_SIZE) {
+        internal_write(data, size);
+        return;
+    }
+
+    memcpy(writer.buffer + writer.used, data, size);
+    writer.used += size;
+}
+
+static void internal_put_u8(u8 value) { internal_put(&value, sizeof(value)); }
+static void internal_put_u32(u32 value) { internal_put(&value, sizeof(value)); }
+static void internal_put_i32(i32 value) { internal_put(&value, sizeof(value)); }
+static void internal_put_f32(f32 value) { internal_put(&value, sizeof(value)); }
+
+static void internal_put_rect(const uv_rect* rect) {
+    f32 values[4] = { rect->u0, rect->v0, rect->u1, rect->v1 };
+    internal_put(values, sizeof(values));
+}
+
+static void internal_put_color(color4 color) {
+    f32 values[4] = { color.r, color.g, color.b, color.a };
+    internal_put(values, sizeof(values));
+}
+
+// texture is what the sprite's texture was written as
+static void internal_put_sprite(const sprite_instance* sprite, i32 texture) {
+    f32 values[6] = { sprite->x, sprite->y, sprite->width, sprite->height, sprite->rotation, sprite->z };
+    internal_put(values, sizeof(values));
+    internal_put_i32(texture);
+    internal_put_rect(&sprite->rect);
+    internal_put_color(sprite->color);
+}
+
+// Writes the size of a texture the first time it is used and again when a reused id has another size,
+// returns the id to record it as
+static i32 internal_capture_texture(i32 texture) {
+    const texture_array_entry* entry = texture_array_get(texture);
+    if (!entry) return -1; // Drawn untextured
+
+    u32 id = (u32)texture;
+    if (id >= writer.textures_seen_count) {
+        u32 new_count = id + 64;
+        captured_texture* seen = (captured_texture*)realloc(writer.textures_seen, sizeof(captured_texture) * new_count);
+        if (!seen) return -1;
+
+        memset(seen + writer.textures_seen_count, 0, sizeof(captured_texture) * (new_count - writer.textures_seen_count));
+        writer.textures_seen = seen;
+        writer.textures_seen_count = new_count;
+    }
+
+    captured_texture* seen = &writer.textures_seen[id];
+    if (seen->width != entry->width || seen->height != entry->height) {
+        seen->width = entry->width;
+        seen->height = entry->height;
+        internal_put_u8(FRAME_CAPTURE_TEXTURE);
+        internal_put_u32(id);
+        internal_put_i32(entry->width);
+        internal_put_i32(entry->height);
+    }
+
+    return texture;
+}
+
+// Writes the glyph table the first time and whenever it changes, -1 once the font table is full
+static i32 internal_capture_font(const bitmap_font* font) {
+    u32 id = 0;
+    while (id < writer.font_count && writer.fonts[id] != font) id++;
+
+    if (id == writer.font_count) {
+        if (id == FRAME_CAPTURE_MAX_FONTS) return -1;
+        writer.fonts[id] = font;
+        writer.font_count++;
+    }
+    else if (writer.font_versions[id] == font->glyph_version) {
+        return (i32)id;
+    }
+
+    writer.font_versions[id] = font->glyph_version;
+    i32 texture = internal_capture_texture(font->texture_id);
+
+    internal_put_u8(FRAME_CAPTURE_FONT);
+    internal_put_u32(id);
+    internal_put_i32(texture);
+    internal_put_i32(font->glyph_width);
+    internal_put_i32(font->glyph_height);
+    internal_put_i32(font->atlas_columns);
+    internal_put_i32(font->atlas_rows);
+    internal_put_f32(font->space_width);
+    internal_put_f32(font->kerning);
+
+    for (u32 i = 0; i < BITMAP_FONT_GLYPHS; i++) {
+        bitmap_glyph glyph = bitmap_font_get_glyph(font, (u8)i);
+        internal_put_rect(&glyph.rect);
+        internal_put_f32(glyph.advance);
+        internal_put_u8(glyph.visible);
+    }
+
+    return (i32)id;
+}
+
+// Finds the batch's id, a batch seen for the first time is written as created with its current sprites
+static i32 internal_capture_static_batch(const renderer2D_static_batch* batch, u32 capacity, const sprite_instance* sprites, u32 count) {
+    for (u32 i = 0; i < writer.batch_count; i++) {
+        if (writer.batches[i] == batch) return (i32)i;
+    }
+
+    if (writer.batch_count == writer.batch_capacity) {
+        u32 new_capacity = writer.batch_capacity ? writer.batch_capacity * 2 : 16;
+        const renderer2D_static_batch** batches = (const renderer2D_static_batch**)realloc((void*)writer.batches, sizeof(renderer2D_static_batch*) * new_capacity);
+        if (!batches) return -1;
+
+        writer.batches = batches;
+        writer.batch_capacity = new_capacity;
+    }
+
+    u32 id = writer.batch_count++;
+    writer.batches[id] = batch;
+
+    internal_put_u8(FRAME_CAPTURE_STATIC_CREATE);
+    internal_put_u32(id);
+    internal_put_u32(capacity);
+
+    for (u32 i = 0; i < count; i++) {
+        i32 texture = internal_capture_texture(sprites[i].texture);
+
+        internal_put_u8(FRAME_CAPTURE_STATIC_SET);
+        internal_put_u32(id);
+        internal_put_u32(i);
+        internal_put_sprite(&sprites[i], texture);
+    }
+
+    return (i32)id;
+}
+
+// -- WRITER INTERNAL FUNCTIONS --
+
+// -- WRITER FUNCTIONS --
+
+u8 frame_capture_open(const char* path, i32 width, i32 height, u32 frame_count) {
+    frame_capture_close();
+    if (frame_count == 0) return false;
+
+    writer.file = fopen(path, "wb");
+    if (!writer.file) return false;
+
+    writer.frames_left = frame_count;
+
+    internal_put_u32(FRAME_CAPTURE_MAGIC);
+    internal_put_u32(FRAME_CAPTURE_VERSION);
+    internal_put_i32(width);
+    internal_put_i32(height);
+    return true;
+}
+
+void frame_capture_close() {
+    if (writer.file) {
+        internal_flush_buffer();
+        fclose(writer.file);
+    }
+
+    free(writer.textures_seen);
+    free((void*)writer.batches);
+    memset(&writer, 0, sizeof(writer));
+}
+
+u8 frame_capture_begin_frame(u8 deferred, u8 instanced, f32 camera_x, f32 camera_y) {
+    if (!writer.file || writer.frames_left == 0) return false;
+
+    writer.in_frame = true;
+    internal_put_u8(FRAME_CAPTURE_BEGIN_FRAME);
+    internal_put_u8(deferred);
+    internal_put_u8(instanced);
+    internal_put_f32(camera_x);
+    internal_put_f32(camera_y);
+    return true;
+}
+
+void frame_capture_end_frame() {
+    if (!writer.in_frame) return;
+
+    writer.in_frame = false;
+    internal_put_u8(FRAME_CAPTURE_END_FRAME);
+
+    if (writer.frames_left > 0) writer.frames_left--;
+    if (writer.frames_left == 0) {
+        frame_capture_close();
+    }
+}
+
+void frame_capture_quad(f32 x, f32 y, f32 width, f32 height, f32 rotation, const uv_rect* rect, color4 color, i32 texture, f32 z) {
+    i32 captured_texture = internal_capture_texture(texture);
+
+    f32 values[6] = { x, y, width, height, rotation, z };
+    internal_put_u8(FRAME_CAPTURE_QUAD);
+    internal_put(values, sizeof(values));
+    internal_put_i32(captured_texture);
+    internal_put_rect(rect);
+    internal_put_color(color);
+}
+
+void frame_capture_sprites(const sprite_instance* sprites, u32 count) {
+    // Sizes go out before the record that uses them
+    for (u32 i = 0; i < count; i++) {
+        internal_capture_texture(sprites[i].texture);
+    }
+
+    internal_put_u8(FRAME_CAPTURE_SPRITES);
+    internal_put_u32(count);
+    for (u32 i = 0; i < count; i++) {
+        internal_put_sprite(&sprites[i], texture_array_get(sprites[i].texture) ? sprites[i].texture : -1);
+    }
+}
+
+void frame_capture_text(f32 x, f32 y, f32 font_size, const char* text, const bitmap_font* font, color4 color, f32 z) {
+    i32 id = internal_capture_font(font);
+    if (id < 0) return; // More fonts than the capture tracks, the text is missing from the replay
+
+    u32 length = (u32)strlen(text);
+    f32 values[4] = { x, y, font_size, z };
+
+    internal_put_u8(FRAME_CAPTURE_TEXT);
+    internal_put_u32((u32)id);
+    internal_put(values, sizeof(values));
+    internal_put_color(color);
+    internal_put_u32(length);
+    internal_put(text, length);
+}
+
+void frame_capture_scissor(u8 enabled, i32 x, i32 y, i32 width, i32 height) {
+    internal_put_u8(FRAME_CAPTURE_SCISSOR);
+    internal_put_u8(enabled);
+    internal_put_i32(x);
+    internal_put_i32(y);
+    internal_put_i32(width);
+    internal_put_i32(height);
+}
+
+void frame_capture_deferred(u8 enabled) {
+    internal_put_u8(FRAME_CAPTURE_DEFERRED);
+    internal_put_u8(enabled);
+}
+
+void frame_capture_instancing(u8 enabled) {
+    internal_put_u8(FRAME_CAPTURE_INSTANCING);
+    internal_put_u8(enabled);
+}
+
+void frame_capture_flush() {
+    internal_put_u8(FRAME_CAPTURE_FLUSH);
+}
+
+void frame_capture_static_set(const renderer2D_static_batch* batch, u32 capacity, const sprite_instance* sprites, u32 count,
+                              u32 index, const sprite_instance* sprite) {
+    if (!writer.file) return;
+
+    i32 id = internal_capture_static_batch(batch, capacity, sprites, count);
+    if (id < 0) return;
+
+    i32 texture = internal_capture_texture(sprite->texture);
+
+    internal_put_u8(FRAME_CAPTURE_STATIC_SET);
+    internal_put_u32((u32)id);
+    internal_put_u32(index);
+    internal_put_sprite(sprite, texture);
+}
+
+void frame_capture_static_truncate(const renderer2D_static_batch* batch, u32 capacity, const sprite_instance* sprites, u32 count, u32 new_count) {
+    if (!writer.file) return;
+
+    i32 id = internal_capture_static_batch(batch, capacity, sprites, count);
+    if (id < 0) return;
+
+    internal_put_u8(FRAME_CAPTURE_STATIC_TRUNCATE);
+    internal_put_u32((u32)id);
+    internal_put_u32(new_count);
+}
+
+void frame_capture_static_draw(const renderer2D_static_batch* batch, u32 capacity, const sprite_instance* sprites, u32 count) {
+    if (!writer.file) return;
+
+    i32 id = internal_capture_static_batch(batch, capacity, sprites, count);
+    if (id < 0) return;
+
+    internal_put_u8(FRAME_CAPTURE_STATIC_DRAW);
+    internal_put_u32((u32)id);
+}
+
+void frame_capture_static_forget(const renderer2D_static_batch* batch) {
+    if (!writer.file) return;
+
+    for (u32 i = 0; i < writer.batch_count; i++) {
+        if (writer.batches[i] == batch) {
+            writer.batches[i] = NULL; // Ids aren't reused, a new batch at this address gets a new one
+            internal_put_u8(FRAME_CAPTURE_STATIC_DESTROY);
+            internal_put_u32(i);
+            return;
+        }
+    }
+}
+
+// -- WRITER FUNCTIONS --
+
+// -- REPLAY INTERNAL FUNCTIONS --
+
+static void internal_read(capture_reader* reader, void* out, size_t size) {
+    if (reader->failed || reader->size - reader->offset < size) {
+        reader->failed = true;
+        memset(out, 0, size);
+        return;
+    }
+
+    memcpy(out, reader->data + reader->offset, size);
+    reader->offset += size;
+}
+
+static u8 internal_read_u8(capture_reader* reader) { u8 value; internal_read(reader, &value, sizeof(value)); return value; }
+static u32 internal_read_u32(capture_reader* reader) { u32 value; internal_read(reader, &value, sizeof(value)); return value; }
+static i32 internal_read_i32(capture_reader* reader) { i32 value; internal_read(reader, &value, sizeof(value)); return value; }
+static f32 internal_read_f32(capture_reader* reader) { f32 value; internal_read(reader, &value, sizeof(value)); return value; }
+
+static void internal_read_rect(capture_reader* reader, uv_rect* rect) {
+    f32 values[4];
+    internal_read(reader, values, sizeof(values));
+    *rect = (uv_rect){ values[0], values[1], values[2], values[3] };
+}
+
+static color4 internal_read_color(capture_reader* reader) {
+    f32 values[4];
+    internal_read(reader, values, sizeof(values));
+    return (color4){ values[0], values[1], values[2], values[3] };
+}
+
+// Captured texture ids are swapped for the replay's
+static i32 internal_replay_texture(const replay_state* state, i32 texture) {
+    if (texture < 0 || (u32)texture >= state->texture_count) return -1;
+    return state->textures[texture];
+}
+
+static void internal_read_sprite(capture_reader* reader, const replay_state* state, sprite_instance* sprite) {
+    f32 values[6];
+    internal_read(reader, values, sizeof(values));
+    sprite->x = values[0];
+    sprite->y = values[1];
+    sprite->width = values[2];
+    sprite->height = values[3];
+    sprite->rotation = values[4];
+    sprite->z = values[5];
+    sprite->texture = internal_replay_texture(state, internal_read_i32(reader));
+    internal_read_rect(reader, &sprite->rect);
+    sprite->color = internal_read_color(reader);
+}
+
+// Solid white, created once and kept for every loop. An id written again with another size was reused
+// by the game, its texture is created again.
+static u8 internal_replay_create_texture(replay_state* state, u32 id, i32 width, i32 height) {
+    if (id >= FRAME_CAPTURE_MAX_TEXTURE_ID || width <= 0 || height <= 0) return false;
+
+    if (id >= state->texture_count) {
+        u32 new_count = id + 64;
+        i32* textures = (i32*)realloc(state->textures, sizeof(i32) * new_count);
+        if (!textures) return false;
+
+        for (u32 i = state->texture_count; i < new_count; i++) textures[i] = -1;
+        state->textures = textures;
+        state->texture_count = new_count;
+    }
+
+    if (state->textures[id] >= 0) {
+        const texture_array_entry* entry = texture_array_get(state->textures[id]);
+        if (entry && entry->width == width && entry->height == height) return true;
+
+        texture_array_destroy(state->textures[id]);
+        state->textures[id] = -1;
+    }
+
+    // The size comes from the file, one the pages can't hold draws untextured without allocating its pixels
+    if (width > texture_array_max_size() || height > texture_array_max_size()) return true;
+
+    u8* pixels = (u8*)malloc((size_t)width * (size_t)height * 4);
+    if (!pixels) return false;
+
+    memset(pixels, 0xFF, (size_t)width * (size_t)height * 4);
+    state->textures[id] = texture_array_create(width, height, pixels);
+    free(pixels);
+    return true; // A texture the pages can't hold draws untextured, like it would in the game
+}
+
+static u8 internal_replay_font(capture_reader* reader, replay_state* state) {
+    u32 id = internal_read_u32(reader);
+    if (id > state->font_count || id >= FRAME_CAPTURE_MAX_FONTS) return false;
+
+    bitmap_font* font = &state->fonts[id];
+    font->texture_id = internal_replay_texture(state, internal_read_i32(reader));
+    font->glyph_width = internal_read_i32(reader);
+    font->glyph_height = internal_read_i32(reader);
+    font->atlas_columns = internal_read_i32(reader);
+    font->atlas_rows = internal_read_i32(reader);
+    font->space_width = internal_read_f32(reader);
+    font->kerning = internal_read_f32(reader);
+
+    for (u32 i = 0; i < BITMAP_FONT_GLYPHS; i++) {
+        internal_read_rect(reader, &font->glyphs[i].rect);
+        font->glyphs[i].advance = internal_read_f32(reader);
+        font->glyphs[i].visible = internal_read_u8(reader);
+    }
+
+    bitmap_font_glyphs_changed(font); // Every font record is a new table for the text cache
+    if (id == state->font_count) state->font_count++;
+    return true;
+}
+
+static u8 internal_replay_text(capture_reader* reader, replay_state* state) {
+    u32 id = internal_read_u32(reader);
+    f32 values[4];
+    internal_read(reader, values, sizeof(values));
+    color4 color = internal_read_color(reader);
+    u32 length = internal_read_u32(reader);
+
+    if (id >= state->font_count || length > reader->size - reader->offset) return false;
+
+    if (length + 1 > state->text_capacity) {
+        char* text = (char*)realloc(state->text, length + 1);
+        if (!text) return false;
+
+        state->text = text;
+        state->text_capacity = length + 1;
+    }
+
+    internal_read(reader, state->text, length);
+    state->text[length] = '\0';
+
+    renderer2D_draw_bitmap_text(values[0], values[1], values[2], state->text, &state->fonts[id], color, values[3]);
+    return true;
+}
+
+static u8 internal_replay_sprites(capture_reader* reader, replay_state* state) {
+    u32 count = internal_read_u32(reader);
+    if ((size_t)count * FRAME_CAPTURE_SPRITE_SIZE > reader->size - reader->offset) return false;
+
+    if (count > state->sprite_capacity) {
+        sprite_instance* sprites = (sprite_instance*)realloc(state->sprites, sizeof(sprite_instance) * count);
+        if (!sprites) return false;
+
+        state->sprites = sprites;
+        state->sprite_capacity = count;
+    }
+
+    for (u32 i = 0; i < count; i++) {
+        internal_read_sprite(reader, state, &state->sprites[i]);
+    }
+
+    renderer2D_draw_sprites(state->sprites, count);
+    return true;
+}
+
+static renderer2D_static_batch* internal_replay_batch(capture_reader* reader, replay_state* state) {
+    u32 id = internal_read_u32(reader);
+    return id < state->batch_count ? state->batches[id] : NULL;
+}
+
+static u8 internal_replay_create_batch(capture_reader* reader, replay_state* state) {
+    u32 id = internal_read_u32(reader);
+    u32 capacity = internal_read_u32(reader);
+    if (id != state->batch_count) return false; // Ids are handed out in order
+
+    if (state->batch_count == state->batch_capacity) {
+        u32 new_capacity = state->batch_capacity ? state->batch_capacity * 2 : 16;
+        renderer2D_static_batch** batches = (renderer2D_static_batch**)realloc(state->batches, sizeof(renderer2D_static_batch*) * new_capacity);
+        if (!batches) return false;
+
+        state->batches = batches;
+        state->batch_capacity = new_capacity;
+    }
+
+    state->batches[id] = renderer2D_static_batch_create(capacity);
+    state->batch_count++;
+    return state->batches[id] != NULL;
+}
+
+static void internal_replay_destroy_batches(replay_state* state) {
+    for (u32 i = 0; i < state->batch_count; i++) {
+        renderer2D_static_batch_destroy(state->batches[i]);
+    }
+    state->batch_count = 0;
+}
+
+// Plays one record, false if it is damaged
+static u8 internal_replay_record(capture_reader* reader, replay_state* state, u8 type) {
+    switch (type) {
+    case FRAME_CAPTURE_BEGIN_FRAME: {
+        u8 deferred = internal_read_u8(reader);
+        u8 instanced = internal_read_u8(reader);
+        f32 camera_x = internal_read_f32(reader);
+        f32 camera_y = internal_read_f32(reader);
+        renderer2D_set_deferred(deferred);
+        renderer2D_set_instancing(instanced);
+        renderer2D_set_camera(camera_x, camera_y);
+        renderer2D_begin_frame();
+        return true;
+    }
+    case FRAME_CAPTURE_END_FRAME:
+        renderer2D_end_frame();
+        return true;
+    case FRAME_CAPTURE_TEXTURE: {
+        u32 id = internal_read_u32(reader);
+        i32 width = internal_read_i32(reader);
+        i32 height = internal_read_i32(reader);
+        return !reader->failed && internal_replay_create_texture(state, id, width, height);
+    }
+    case FRAME_CAPTURE_FONT:
+        return internal_replay_font(reader, state);
+    case FRAME_CAPTURE_QUAD: {
+        f32 values[6];
+        internal_read(reader, values, sizeof(values));
+        i32 texture = internal_replay_texture(state, internal_read_i32(reader));
+        uv_rect rect;
+        internal_read_rect(reader, &rect);
+        color4 color = internal_read_color(reader);
+        renderer2D_draw_rotated_quad_atlas(values[0], values[1], values[2], values[3], texture, &rect, color, values[4], values[5]);
+        return true;
+    }
+    case FRAME_CAPTURE_SPRITES:
+        return internal_replay_sprites(reader, state);
+    case FRAME_CAPTURE_TEXT:
+        return internal_replay_text(reader, state);
+    case FRAME_CAPTURE_SCISSOR: {
+        u8 enabled = internal_read_u8(reader);
+        i32 values[4];
+        internal_read(reader, values, sizeof(values));
+        if (enabled) renderer2D_set_scissor(values[0], values[1], values[2], values[3]);
+        else renderer2D_disable_scissor();
+        return true;
+    }
+    case FRAME_CAPTURE_DEFERRED:
+        renderer2D_set_deferred(internal_read_u8(reader));
+        return true;
+    case FRAME_CAPTURE_INSTANCING:
+        renderer2D_set_instancing(internal_read_u8(reader));
+        return true;
+    case FRAME_CAPTURE_FLUSH:
+        renderer2D_flush();
+        return true;
+    case FRAME_CAPTURE_STATIC_CREATE:
+        return internal_replay_create_batch(reader, state);
+    case FRAME_CAPTURE_STATIC_DESTROY: {
+        u32 id = internal_read_u32(reader);
+        if (id >= state->batch_count) return false;
+
+        renderer2D_static_batch_destroy(state->batches[id]);
+        state->batches[id] = NULL;
+        return true;
+    }
+    case FRAME_CAPTURE_STATIC_SET: {
+        renderer2D_static_batch* batch = internal_replay_batch(reader, state);
+        u32 index = internal_read_u32(reader);
+        sprite_instance sprite;
+        internal_read_sprite(reader, state, &sprite);
+        if (!batch) return false;
+
+        renderer2D_static_batch_set(batch, index, &sprite); // Fails the same way it did in the game
+        return true;
+    }
+    case FRAME_CAPTURE_STATIC_TRUNCATE: {
+        renderer2D_static_batch* batch = internal_replay_batch(reader, state);
+        u32 count = internal_read_u32(reader);
+        if (!batch) return false;
+
+        renderer2D_static_batch_truncate(batch, count);
+        return true;
+    }
+    case FRAME_CAPTURE_STATIC_DRAW: {
+        renderer2D_static_batch* batch = internal_replay_batch(reader, state);
+        if (!batch) return false;
+
+        renderer2D_draw_static_batch(batch);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+static u8* internal_read_file(const char* path, size_t* out_size) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+
+    u8* data = NULL;
+    size_t size = 0;
+    size_t capacity = 0;
+
+    for (;;) {
+        if (size == capacity) {
+            capacity = capacity ? capacity * 2 : 1024 * 1024;
+            u8* grown = (u8*)realloc(data, capacity);
+            if (!grown) {
+                free(data);
+                fclose(file);
+                return NULL;
+            }
+            data = grown;
+        }
+
+        size_t read = fread(data + size, 1, capacity - size, file);
+        if (read == 0) break;
+        size += read;
+    }
+
+    fclose(file);
+    *out_size = size;
+    return data;
+}
+
+// -- REPLAY INTERNAL FUNCTIONS --
+
+// -- REPLAY FUNCTIONS --
+
+i32 frame_capture_replay(const char* path, u32 loops) {
+    size_t size = 0;
+    u8* data = internal_read_file(path, &size);
+    if (!data) {
+        printf("Failed to read frame capture %s!\n", path);
+        return -1;
+    }
+
+    capture_reader reader = { data, size, 0, false };
+    u32 magic = internal_read_u32(&reader);
+    u32 version = internal_read_u32(&reader);
+    i32 width = internal_read_i32(&reader);
+    i32 height = internal_read_i32(&reader);
+
+    if (reader.failed || magic != FRAME_CAPTURE_MAGIC || version != FRAME_CAPTURE_VERSION) {
+        printf("%s is not a version %u frame capture!\n", path, FRAME_CAPTURE_VERSION);
+        free(data);
+        return -1;
+    }
+
+    replay_state state = { 0 };
+    state.fonts = (bitmap_font*)calloc(FRAME_CAPTURE_MAX_FONTS, sizeof(bitmap_font));
+    if (!state.fonts) {
+        printf("Failed to allocate the replay fonts!\n");
+        free(data);
+        return -1;
+    }
+
+    printf("frame capture replay: %s, captured at %dx%d, %u loops\n", path, width, height, loops);
+
+    size_t records_offset = reader.offset;
+    i32 result = 0;
+
+    // The first loop also creates the textures, later ones show the batcher alone
+    for (u32 loop = 0; loop < loops && result == 0; loop++) {
+        reader.offset = records_offset;
+        state.font_count = 0;
+
+        u32 frames = 0;
+        f64 total_ms = 0.0, min_ms = DBL_MAX, max_ms = 0.0;
+        f64 draw_calls = 0.0, quads = 0.0, static_quads = 0.0;
+        f64 frame_start = 0.0;
+        u8 in_frame = false;
+
+        while (reader.offset < reader.size) {
+            u8 type = internal_read_u8(&reader);
+            if (type == FRAME_CAPTURE_BEGIN_FRAME) {
+                frame_start = platform_get_elapsed_time_ms();
+                in_frame = true;
+            }
+
+            if (!internal_replay_record(&reader, &state, type) || reader.failed) {
+                printf("Frame capture %s is damaged at byte %zu!\n", path, reader.offset);
+                result = -1;
+                break;
+            }
+
+            if (type == FRAME_CAPTURE_END_FRAME && in_frame) {
+                f64 frame_ms = platform_get_elapsed_time_ms() - frame_start;
+                in_frame = false;
+
+                renderer2D_frame_stats stats;
+                renderer2D_get_frame_stats(&stats);
+
+                frames++;
+                total_ms += frame_ms;
+                if (frame_ms < min_ms) min_ms = frame_ms;
+                if (frame_ms > max_ms) max_ms = frame_ms;
+                draw_calls += stats.draw_calls;
+                quads += stats.quads;
+                static_quads += stats.static_quads;
+            }
+        }
+
+        // A capture cut short ends inside a frame
+        renderer2D_end_frame();
+        internal_replay_destroy_batches(&state);
+
+        if (frames > 0) {
+            printf("  loop %u: %u frames | frame %8.3f ms avg %8.3f min %8.3f max | %8.1f draw calls %10.1f quads %10.1f static quads per frame\n",
+                   loop, frames, total_ms / frames, min_ms, max_ms, draw_calls / frames, quads / frames, static_quads / frames);
+        }
+    }
+
+    for (u32 i = 0; i < state.texture_count; i++) {
+        if (state.textures[i] >= 0) texture_array_destroy(state.textures[i]);
+    }
+
+    free(state.textures);
+    free(state.fonts);
+    free(state.batches);
+    free(state.sprites);
+    free(state.text);
+    free(data);
+    return result;
+}
+
+// -- REPLAY FUNCTIONS --
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <common.h>
+#include <renderer/renderer2D.h>
+
+// Binary recording of the renderer2D calls of a range of frames, replayed through the batcher without the
+// game. The file is a header (magic, version, screen size) followed by records: a u8 type and its fields,
+// little endian. Textures, fonts and static batches are written the first time a captured frame uses them:
+// textures by size only, so a replay measures batching and uploads rather than what the art looks like,
+// fonts with their glyph table and static batches with the sprites they held at that point. A texture id
+// the game reused for another size is written again.
+// renderer2D calls the writer, use renderer2D_capture_frames to start a capture.
+
+#define FRAME_CAPTURE_MAGIC 0x43443251u // "Q2DC"
+#define FRAME_CAPTURE_VERSION 2
+#define FRAME_CAPTURE_MAX_FONTS 16
+
+typedef enum {
+    FRAME_CAPTURE_BEGIN_FRAME = 1,  // u8 deferred, u8 instanced, f32 camera x, y
+    FRAME_CAPTURE_END_FRAME,
+    FRAME_CAPTURE_TEXTURE,          // u32 id, i32 width, i32 height
+    FRAME_CAPTURE_FONT,             // u32 id, i32 texture, metrics, the glyph table
+    FRAME_CAPTURE_QUAD,             // x, y, width, height, rotation, z, i32 texture, rect, color
+    FRAME_CAPTURE_SPRITES,          // u32 count, the sprites
+    FRAME_CAPTURE_TEXT,             // u32 font, x, y, font size, z, color, u32 length, the characters
+    FRAME_CAPTURE_SCISSOR,          // u8 enabled, i32 x, y, width, height
+    FRAME_CAPTURE_DEFERRED,         // u8 enabled
+    FRAME_CAPTURE_INSTANCING,       // u8 enabled
+    FRAME_CAPTURE_FLUSH,
+    FRAME_CAPTURE_STATIC_CREATE,    // u32 id, u32 capacity
+    FRAME_CAPTURE_STATIC_DESTROY,   // u32 id
+    FRAME_CAPTURE_STATIC_SET,       // u32 id, u32 index, the sprite
+    FRAME_CAPTURE_STATIC_TRUNCATE,  // u32 id, u32 count
+    FRAME_CAPTURE_STATIC_DRAW       // u32 id
+} frame_capture_record;
+
+// Records the next frame_count frames, false if the file can't be created
+u8 frame_capture_open(const char* path, i32 width, i32 height, u32 frame_count);
+void frame_capture_close(); // Ends the capture early, the frames written so far stay a valid capture
+u8 frame_capture_begin_frame(u8 deferred, u8 instanced, f32 camera_x, f32 camera_y); // True if this frame is captured
+void frame_capture_end_frame(); // Closes the file after the last frame
+
+void frame_capture_quad(f32 x, f32 y, f32 width, f32 height, f32 rotation, const uv_rect* rect, color4 color, i32 texture, f32 z);
+void frame_capture_sprites(const sprite_instance* sprites, u32 count);
+void frame_capture_text(f32 x, f32 y, f32 font_size, const char* text, const bitmap_font* font, color4 color, f32 z);
+void frame_capture_scissor(u8 enabled, i32 x, i32 y, i32 width, i32 height);
+void frame_capture_deferred(u8 enabled);
+void frame_capture_instancing(u8 enabled);
+void frame_capture_flush();
+
+// Batches are identified by address. One seen for the first time is written with its current sprites first.
+void frame_capture_static_set(const renderer2D_static_batch* batch, u32 capacity, const sprite_instance* sprites, u32 count,
+                              u32 index, const sprite_instance* sprite);
+void frame_capture_static_truncate(const renderer2D_static_batch* batch, u32 capacity, const sprite_instance* sprites, u32 count, u32 new_count);
+void frame_capture_static_draw(const renderer2D_static_batch* batch, u32 capacity, const sprite_instance* sprites, u32 count);
+void frame_capture_static_forget(const renderer2D_static_batch* batch); // Call on destroy, even outside captured frames
+
+// Plays the capture loops times through the initialized renderer and prints frame times and batching stats,
+// run with --replay. Textures are created as solid white and destroyed at the end.
+i32 frame_capture_replay(const char* path, u32 loops);
@@ -0,0 +1,259 @@
+#include <renderer/quad_kernels.h>
+
+#include <math.h>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define QUAD_KERNELS_SIMD
+#include <immintrin.h>
+#endif
+
+#define QUAD_KERNEL_PI 3.14159265358979f
+#define QUAD_KERNEL_HALF_PI 1.57079632679490f
+#define QUAD_KERNEL_INV_TWO_PI 0.159154943091895f
+
+// Taylor coefficients, the angle is folded into [-pi / 2, pi / 2] first
+#define QUAD_KERNEL_S3 (-1.0f / 6.0f)
+#define QUAD_KERNEL_S5 (1.0f / 120.0f)
+#define QUAD_KERNEL_S7 (-1.0f / 5040.0f)
+#define QUAD_KERNEL_S9 (1.0f / 362880.0f)
+#define QUAD_KERNEL_C2 (-1.0f / 2.0f)
+#define QUAD_KERNEL_C4 (1.0f / 24.0f)
+#define QUAD_KERNEL_C6 (-1.0f / 720.0f)
+#define QUAD_KERNEL_C8 (1.0f / 40320.0f)
+#define QUAD_KERNEL_C10 (-1.0f / 3628800.0f)
+
+// Cody-Waite split of 2 pi, so large angles lose less precision in the reduction
+#define QUAD_KERNEL_TWO_PI_HI 6.28125f
+#define QUAD_KERNEL_TWO_PI_LO 0.00193530717958647f
+
+// -- SCALAR --
+
+void quad_kernel_sincos(f32 angle, f32* out_sin, f32* out_cos) {
+    // Reduce to [-pi, pi], rounding half to even like the SSE and AVX paths so half turns land the same way
+    f32 k = nearbyintf(angle * QUAD_KERNEL_INV_TWO_PI);
+    f32 a = angle - k * QUAD_KERNEL_TWO_PI_HI - k * QUAD_KERNEL_TWO_PI_LO;
+
+    // sin(pi - a) = sin(a), cos(pi - a) = -cos(a)
+    f32 cos_sign = 1.0f;
+    if (a > QUAD_KERNEL_HALF_PI) {
+        a = QUAD_KERNEL_PI - a;
+        cos_sign = -1.0f;
+    }
+    else if (a < -QUAD_KERNEL_HALF_PI) {
+        a = -QUAD_KERNEL_PI - a;
+        cos_sign = -1.0f;
+    }
+
+    f32 a2 = a * a;
+    *out_sin = a * (1.0f + a2 * (QUAD_KERNEL_S3 + a2 * (QUAD_KERNEL_S5 + a2 * (QUAD_KERNEL_S7 + a2 * QUAD_KERNEL_S9))));
+    *out_cos = cos_sign * (1.0f + a2 * (QUAD_KERNEL_C2 + a2 * (QUAD_KERNEL_C4 + a2 * (QUAD_KERNEL_C6 + a2 * (QUAD_KERNEL_C8 + a2 * QUAD_KERNEL_C10)))));
+}
+
+static void internal_corners_scalar(const f32* x, const f32* y, const f32* width, const f32* height, const f32* rotation, u32 count,
+                                    f32 x_offset, f32 y_offset, f32 (*out_corners)[4][2]) {
+    for (u32 i = 0; i < count; i++) {
+        f32 s = 0.0f;
+        f32 c = 1.0f;
+        if (rotation[i] != 0.0f) {
+            quad_kernel_sincos(rotation[i], &s, &c);
+        }
+
+        f32 hw = width[i] * 0.5f;
+        f32 hh = height[i] * 0.5f;
+        f32 cx = x[i] + x_offset;
+        f32 cy = y[i] + y_offset;
+
+        // Rotated half extents, every corner is the center plus or minus these
+        f32 a = hw * c;
+        f32 b = hh * s;
+        f32 d = hw * s;
+        f32 e = hh * c;
+
+        f32 (*corners)[2] = out_corners[i];
+        corners[0][0] = cx - a + b; corners[0][1] = cy - d - e;
+        corners[1][0] = cx + a + b; corners[1][1] = cy + d - e;
+        corners[2][0] = cx + a - b; corners[2][1] = cy + d + e;
+        corners[3][0] = cx - a - b; corners[3][1] = cy - d + e;
+    }
+}
+
+// -- SCALAR --
+
+// -- SSE --
+
+#ifdef QUAD_KERNELS_SIMD
+
+// Four angles at once, same reduction and polynomials as quad_kernel_sincos
+static void internal_sincos_sse(__m128 angle, __m128* out_sin, __m128* out_cos) {
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+    const __m128 pi = _mm_set1_ps(QUAD_KERNEL_PI);
+    const __m128 half_pi = _mm_set1_ps(QUAD_KERNEL_HALF_PI);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    __m128 k = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(angle, _mm_set1_ps(QUAD_KERNEL_INV_TWO_PI))));
+    __m128 a = _mm_sub_ps(angle, _mm_mul_ps(k, _mm_set1_ps(QUAD_KERNEL_TWO_PI_HI)));
+    a = _mm_sub_ps(a, _mm_mul_ps(k, _mm_set1_ps(QUAD_KERNEL_TWO_PI_LO)));
+
+    // Fold |a| > pi / 2 back with a' = sign(a) * pi - a, which also flips the sign of the cosine
+    __m128 a_sign = _mm_and_ps(a, sign_mask);
+    __m128 fold = _mm_cmpgt_ps(_mm_andnot_ps(sign_mask, a), half_pi);
+    __m128 folded = _mm_sub_ps(_mm_or_ps(pi, a_sign), a);
+    a = _mm_or_ps(_mm_and_ps(fold, folded), _mm_andnot_ps(fold, a));
+    __m128 cos_sign = _mm_and_ps(fold, sign_mask);
+
+    __m128 a2 = _mm_mul_ps(a, a);
+
+    __m128 s = _mm_add_ps(_mm_set1_ps(QUAD_KERNEL_S7), _mm_mul_ps(a2, _mm_set1_ps(QUAD_KERNEL_S9)));
+    s = _mm_add_ps(_mm_set1_ps(QUAD_KERNEL_S5), _mm_mul_ps(a2, s));
+    s = _mm_add_ps(_mm_set1_ps(QUAD_KERNEL_S3), _mm_mul_ps(a2, s));
+    s = _mm_mul_ps(a, _mm_add_ps(one, _mm_mul_ps(a2, s)));
+
+    __m128 c = _mm_add_ps(_mm_set1_ps(QUAD_KERNEL_C8), _mm_mul_ps(a2, _mm_set1_ps(QUAD_KERNEL_C10)));
+    c = _mm_add_ps(_mm_set1_ps(QUAD_KERNEL_C6), _mm_mul_ps(a2, c));
+    c = _mm_add_ps(_mm_set1_ps(QUAD_KERNEL_C4), _mm_mul_ps(a2, c));
+    c = _mm_add_ps(_mm_set1_ps(QUAD_KERNEL_C2), _mm_mul_ps(a2, c));
+    c = _mm_add_ps(one, _mm_mul_ps(a2, c));
+
+    *out_sin = s;
+    *out_cos = _mm_xor_ps(c, cos_sign);
+}
+
+// Corners of four quads, each register holds one coordinate of one corner for all four
+static void internal_corners_sse4(__m128 x, __m128 y, __m128 width, __m128 height, __m128 rotation, f32 (*out_corners)[4][2]) {
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    __m128 s, c;
+    internal_sincos_sse(rotation, &s, &c);
+
+    __m128 hw = _mm_mul_ps(width, half);
+    __m128 hh = _mm_mul_ps(height, half);
+    __m128 a = _mm_mul_ps(hw, c);
+    __m128 b = _mm_mul_ps(hh, s);
+    __m128 d = _mm_mul_ps(hw, s);
+    __m128 e = _mm_mul_ps(hh, c);
+
+    __m128 c0x = _mm_add_ps(_mm_sub_ps(x, a), b), c0y = _mm_sub_ps(_mm_sub_ps(y, d), e);
+    __m128 c1x = _mm_add_ps(_mm_add_ps(x, a), b), c1y = _mm_sub_ps(_mm_add_ps(y, d), e);
+    __m128 c2x = _mm_sub_ps(_mm_add_ps(x, a), b), c2y = _mm_add_ps(_mm_add_ps(y, d), e);
+    __m128 c3x = _mm_sub_ps(_mm_sub_ps(x, a), b), c3y = _mm_add_ps(_mm_sub_ps(y, d), e);
+
+    // Transpose so each quad's eight floats are stored together
+    _MM_TRANSPOSE4_PS(c0x, c0y, c1x, c1y);
+    _MM_TRANSPOSE4_PS(c2x, c2y, c3x, c3y);
+
+    _mm_storeu_ps(&out_corners[0][0][0], c0x); _mm_storeu_ps(&out_corners[0][2][0], c2x);
+    _mm_storeu_ps(&out_corners[1][0][0], c0y); _mm_storeu_ps(&out_corners[1][2][0], c2y);
+    _mm_storeu_ps(&out_corners[2][0][0], c1x); _mm_storeu_ps(&out_corners[2][2][0], c3x);
+    _mm_storeu_ps(&out_corners[3][0][0], c1y); _mm_storeu_ps(&out_corners[3][2][0], c3y);
+}
+
+#endif
+
+// -- SSE --
+
+// -- AVX --
+
+#ifdef __AVX__
+
+static void internal_sincos_avx(__m256 angle, __m256* out_sin, __m256* out_cos) {
+    const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+    const __m256 pi = _mm256_set1_ps(QUAD_KERNEL_PI);
+    const __m256 half_pi = _mm256_set1_ps(QUAD_KERNEL_HALF_PI);
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    __m256 k = _mm256_round_ps(_mm256_mul_ps(angle, _mm256_set1_ps(QUAD_KERNEL_INV_TWO_PI)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 a = _mm256_sub_ps(angle, _mm256_mul_ps(k, _mm256_set1_ps(QUAD_KERNEL_TWO_PI_HI)));
+    a = _mm256_sub_ps(a, _mm256_mul_ps(k, _mm256_set1_ps(QUAD_KERNEL_TWO_PI_LO)));
+
+    __m256 a_sign = _mm256_and_ps(a, sign_mask);
+    __m256 fold = _mm256_cmp_ps(_mm256_andnot_ps(sign_mask, a), half_pi, _CMP_GT_OQ);
+    a = _mm256_blendv_ps(a, _mm256_sub_ps(_mm256_or_ps(pi, a_sign), a), fold);
+    __m256 cos_sign = _mm256_and_ps(fold, sign_mask);
+
+    __m256 a2 = _mm256_mul_ps(a, a);
+
+    __m256 s = _mm256_add_ps(_mm256_set1_ps(QUAD_KERNEL_S7), _mm256_mul_ps(a2, _mm256_set1_ps(QUAD_KERNEL_S9)));
+    s = _mm256_add_ps(_mm256_set1_ps(QUAD_KERNEL_S5), _mm256_mul_ps(a2, s));
+    s = _mm256_add_ps(_mm256_set1_ps(QUAD_KERNEL_S3), _mm256_mul_ps(a2, s));
+    s = _mm256_mul_ps(a, _mm256_add_ps(one, _mm256_mul_ps(a2, s)));
+
+    __m256 c = _mm256_add_ps(_mm256_set1_ps(QUAD_KERNEL_C8), _mm256_mul_ps(a2, _mm256_set1_ps(QUAD_KERNEL_C10)));
+    c = _mm256_add_ps(_mm256_set1_ps(QUAD_KERNEL_C6), _mm256_mul_ps(a2, c));
+    c = _mm256_add_ps(_mm256_set1_ps(QUAD_KERNEL_C4), _mm256_mul_ps(a2, c));
+    c = _mm256_add_ps(_mm256_set1_ps(QUAD_KERNEL_C2), _mm256_mul_ps(a2, c));
+    c = _mm256_add_ps(one, _mm256_mul_ps(a2, c));
+
+    *out_sin = s;
+    *out_cos = _mm256_xor_ps(c, cos_sign);
+}
+
+// Eight quads per call, the halves are transposed and stored with the SSE shuffles
+static void internal_corners_avx8(const f32* x, const f32* y, const f32* width, const f32* height, const f32* rotation,
+                                  __m256 x_offset, __m256 y_offset, f32 (*out_corners)[4][2]) {
+    const __m256 half = _mm256_set1_ps(0.5f);
+
+    __m256 s, c;
+    internal_sincos_avx(_mm256_loadu_ps(rotation), &s, &c);
+
+    __m256 cx = _mm256_add_ps(_mm256_loadu_ps(x), x_offset);
+    __m256 cy = _mm256_add_ps(_mm256_loadu_ps(y), y_offset);
+    __m256 hw = _mm256_mul_ps(_mm256_loadu_ps(width), half);
+    __m256 hh = _mm256_mul_ps(_mm256_loadu_ps(height), half);
+    __m256 a = _mm256_mul_ps(hw, c);
+    __m256 b = _mm256_mul_ps(hh, s);
+    __m256 d = _mm256_mul_ps(hw, s);
+    __m256 e = _mm256_mul_ps(hh, c);
+
+    __m256 corners[8] = {
+        _mm256_add_ps(_mm256_sub_ps(cx, a), b), _mm256_sub_ps(_mm256_sub_ps(cy, d), e),
+        _mm256_add_ps(_mm256_add_ps(cx, a), b), _mm256_sub_ps(_mm256_add_ps(cy, d), e),
+        _mm256_sub_ps(_mm256_add_ps(cx, a), b), _mm256_add_ps(_mm256_add_ps(cy, d), e),
+        _mm256_sub_ps(_mm256_sub_ps(cx, a), b), _mm256_add_ps(_mm256_sub_ps(cy, d), e)
+    };
+
+    for (int half_index = 0; half_index < 2; half_index++) {
+        __m128 r[8];
+        for (int i = 0; i < 8; i++) {
+            r[i] = half_index ? _mm256_extractf128_ps(corners[i], 1) : _mm256_castps256_ps128(corners[i]);
+        }
+
+        _MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+        _MM_TRANSPOSE4_PS(r[4], r[5], r[6], r[7]);
+
+        f32 (*quads)[4][2] = out_corners + half_index * 4;
+        for (int i = 0; i < 4; i++) {
+            _mm_storeu_ps(&quads[i][0][0], r[i]);
+            _mm_storeu_ps(&quads[i][2][0], r[i + 4]);
+        }
+    }
+}
+
+#endif
+
+// -- AVX --
+
+void quad_kernel_corners(const f32* x, const f32* y, const f32* width, const f32* height, const f32* rotation, u32 count,
+                         f32 x_offset, f32 y_offset, f32 (*out_corners)[4][2]) {
+    u32 i = 0;
+
+#ifdef __AVX__
+    const __m256 x_offset8 = _mm256_set1_ps(x_offset);
+    const __m256 y_offset8 = _mm256_set1_ps(y_offset);
+
+    for (; i + 8 <= count; i += 8) {
+        internal_corners_avx8(x + i, y + i, width + i, height + i, rotation + i, x_offset8, y_offset8, out_corners + i);
+    }
+#endif
+
+#ifdef QUAD_KERNELS_SIMD
+    const __m128 x_offset4 = _mm_set1_ps(x_offset);
+    const __m128 y_offset4 = _mm_set1_ps(y_offset);
+
+    for (; i + 4 <= count; i += 4) {
+        internal_corners_sse4(_mm_add_ps(_mm_loadu_ps(x + i), x_offset4), _mm_add_ps(_mm_loadu_ps(y + i), y_offset4),
+                              _mm_loadu_ps(width + i), _mm_loadu_ps(height + i), _mm_loadu_ps(rotation + i), out_corners + i);
+    }
+#endif
+
+    internal_corners_scalar(x + i, y + i, width + i, height + i, rotation + i, count - i, x_offset, y_offset, out_corners + i);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <common.h>
+
+// Corner math for many quads at once. Inputs are SoA so the SSE path handles 4 quads per iteration and
+// the AVX path 8, with a scalar loop for the rest and for builds without SIMD. Rotation uses a polynomial
+// sincos accurate to 4e-6 (well under a pixel for any sprite size), bit identical on every path.
+
+#define QUAD_KERNEL_CHUNK 64 // Quads callers usually gather into one call, sized for stack arrays
+
+void quad_kernel_sincos(f32 angle, f32* out_sin, f32* out_cos);
+
+// Writes the four corners (bottom left, bottom right, top right, top left before rotation) of every
+// quad centered at x, y to out_corners, with the offset added after rotating
+void quad_kernel_corners(const f32* x, const f32* y, const f32* width, const f32* height, const f32* rotation, u32 count,
+                         f32 x_offset, f32 y_offset, f32 (*out_corners)[4][2]);
@@ -0,0 +1,108 @@
+#include <renderer/render_queue.h>
+#include <core/radix_sort.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// -- INTERNAL FUNCTIONS --
+
+static u8 internal_reserve_commands(render_queue* queue, u32 count) {
+    if (count <= queue->capacity) return true;
+
+    u32 capacity = queue->capacity ? queue->capacity : 1024;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+
+    render_command* commands = (render_command*)realloc(queue->commands, sizeof(render_command) * capacity);
+    if (commands) queue->commands = commands;
+    u64* keys = (u64*)realloc(queue->keys, sizeof(u64) * capacity);
+    if (keys) queue->keys = keys;
+    u64* temp_keys = (u64*)realloc(queue->temp_keys, sizeof(u64) * capacity);
+    if (temp_keys) queue->temp_keys = temp_keys;
+    u32* order = (u32*)realloc(queue->order, sizeof(u32) * capacity);
+    if (order) queue->order = order;
+    u32* temp_order = (u32*)realloc(queue->temp_order, sizeof(u32) * capacity);
+    if (temp_order) queue->temp_order = temp_order;
+
+    if (!commands || !keys || !temp_keys || !order || !temp_order) return false;
+
+    queue->capacity = capacity;
+    return true;
+}
+
+// -- INTERNAL FUNCTIONS --
+
+// -- RENDER QUEUE FUNCTIONS --
+
+void render_queue_init(render_queue* queue) {
+    memset(queue, 0, sizeof(render_queue));
+}
+
+void render_queue_free(render_queue* queue) {
+    free(queue->commands);
+    free(queue->keys);
+    free(queue->temp_keys);
+    free(queue->order);
+    free(queue->temp_order);
+    free(queue->text);
+    memset(queue, 0, sizeof(render_queue));
+}
+
+void render_queue_reset(render_queue* queue) {
+    queue->count = 0;
+    queue->text_size = 0;
+    queue->epoch = 0;
+}
+
+render_command* render_queue_push(render_queue* queue, render_command_type type, f32 z, u32 texture_key) {
+    if (!internal_reserve_commands(queue, queue->count + 1)) return NULL;
+
+    // State changes get the lowest depth so they come before every command of their epoch
+    u64 depth = type == RENDER_COMMAND_SCISSOR ? 0 : radix_sort_float_key(z);
+
+    u32 index = queue->count++;
+    queue->keys[index] = ((u64)queue->epoch << 56) | (depth << 24) | ((u64)(texture_key & 0xFFFF) << 8) | type;
+    queue->order[index] = index;
+
+    render_command* command = &queue->commands[index];
+    command->type = type;
+    command->z = z;
+    return command;
+}
+
+u8 render_queue_push_text(render_queue* queue, const char* text, u32* out_offset) {
+    u32 length = (u32)strlen(text) + 1;
+
+    if (queue->text_size + length > queue->text_capacity) {
+        u32 capacity = queue->text_capacity ? queue->text_capacity : 1024;
+        while (capacity < queue->text_size + length) {
+            capacity *= 2;
+        }
+
+        char* arena = (char*)realloc(queue->text, capacity);
+        if (!arena) return false;
+
+        queue->text = arena;
+        queue->text_capacity = capacity;
+    }
+
+    memcpy(queue->text + queue->text_size, text, length);
+    *out_offset = queue->text_size;
+    queue->text_size += length;
+    return true;
+}
+
+u8 render_queue_next_epoch(render_queue* queue) {
+    if (queue->epoch >= RENDER_QUEUE_MAX_EPOCH) return false;
+
+    queue->epoch++;
+    return true;
+}
+
+void render_queue_sort(render_queue* queue) {
+    // Stable, commands with equal keys keep their submission order
+    radix_sort_u64(queue->keys, queue->order, queue->temp_keys, queue->temp_order, queue->count);
+}
+
+// -- RENDER QUEUE FUNCTIONS --
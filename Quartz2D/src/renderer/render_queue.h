@@ -0,0 +1,86 @@
+#pragma once
+
+#include <common.h>
+#include <renderer/color.h>
+#include <renderer/texture_atlas.h>
+#include <renderer/bitmap_font.h>
+
+// Commands recorded by renderer2D in deferred mode. They are sorted by key once per flush and only
+// then expanded to vertices, so the submission order of the game code doesn't decide the batching.
+//
+// Sort key, compared as one integer:
+//   bits 63..56  state epoch, bumped by every state change so commands never move across one
+//   bits 55..24  depth, ascending so transparent quads blend back to front, 0 for state changes
+//   bits 23..8   texture page then layer
+//   bits  7..0   command type
+
+typedef enum {
+    RENDER_COMMAND_SCISSOR,
+    RENDER_COMMAND_QUAD,
+    RENDER_COMMAND_TEXT,
+    RENDER_COMMAND_STATIC_BATCH
+} render_command_type;
+
+#define RENDER_QUEUE_MAX_EPOCH 255
+
+typedef struct {
+    u32 type;
+    f32 z;
+    color4 color;
+
+    union {
+        struct {
+            f32 x, y, width, height;
+            f32 rotation;  // Radians
+            i32 texture;
+            uv_rect rect;
+        } quad;
+
+        struct {
+            f32 x, y;
+            f32 font_size;
+            const bitmap_font* font;
+            u32 text_offset; // Into the queue's text arena
+        } text;
+
+        struct {
+            i32 x, y, width, height;
+            u8 enabled;
+        } scissor;
+
+        struct {
+            struct renderer2D_static_batch* batch; // Must outlive the flush
+        } static_batch;
+    };
+} render_command;
+
+typedef struct {
+    render_command* commands;
+    u64* keys;
+    u64* temp_keys;
+    u32* order;       // Command indices in sorted order after render_queue_sort
+    u32* temp_order;
+    u32 count;
+    u32 capacity;
+
+    char* text;       // Strings of text commands, copied so callers can reuse their buffers
+    u32 text_size;
+    u32 text_capacity;
+
+    u32 epoch;
+} render_queue;
+
+void render_queue_init(render_queue* queue);
+void render_queue_free(render_queue* queue);
+void render_queue_reset(render_queue* queue);
+
+// Returns NULL if the queue can't grow, the key is built from the command type, epoch, depth and texture
+render_command* render_queue_push(render_queue* queue, render_command_type type, f32 z, u32 texture_key);
+u8 render_queue_push_text(render_queue* queue, const char* text, u32* out_offset);
+u8 render_queue_next_epoch(render_queue* queue); // False once RENDER_QUEUE_MAX_EPOCH is reached
+
+void render_queue_sort(render_queue* queue);
+
+static __inline const render_command* render_queue_get(const render_queue* queue, u32 sorted_index) {
+    return &queue->commands[queue->order[sorted_index]];
+}
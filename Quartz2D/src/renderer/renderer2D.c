@@ -1,4 +1,11 @@
 #include <renderer/renderer2D.h>
+#include <renderer/texture_array.h>
+#include <renderer/render_queue.h>
+#include <renderer/quad_kernels.h>
+#include <renderer/text_cache.h>
+#include <renderer/software_rasterizer.h>
+#include <renderer/frame_capture.h>
+#include <core/job_system.h>
 #include <renderer/shaders/shader_utils.h>
 
 #include <platform/platform.h>
@@ -7,6 +14,7 @@
 #include <glad/glad.h>
 
 // Standard library
+#include <math.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
@@ -15,58 +23,590 @@
 #include <octomath/vec3.h>
 #include <octomath/mat4.h>
 
+// Packed vertices are 20 bytes instead of 40, build with RENDERER2D_PACKED_VERTICES 0 for full float precision.
+// Both layouts feed the same shader: depth is scaled by uDepthScale and a texture index of 8 or more means none.
+#ifndef RENDERER2D_PACKED_VERTICES
+#define RENDERER2D_PACKED_VERTICES 1
+#endif
+
+#define MAX_QUADS RENDERER2D_MAX_BATCH_QUADS
+#define MAX_VERTICES (MAX_QUADS * 4)
+#define MAX_INDICES (MAX_QUADS * 6)
+#define MAX_TEXTURE_SLOTS 8 // Texture array pages bound per batch, each page holds many textures
+#define RENDERER_PARALLEL_MIN_QUADS 256 // Quad runs shorter than this are expanded on the calling thread
+#define RENDERER_PARALLEL_GRAIN 64      // Quads per job
+#define RENDERER_DEPTH_RANGE 100.0f // Far plane of the projection, packed depth covers [0, RENDERER_DEPTH_RANGE]
+
+#if RENDERER2D_PACKED_VERTICES
+
+typedef struct {
+	f32 position[2];
+	u16 depth;         // Normalized, multiplied by RENDERER_DEPTH_RANGE in the shader
+	u8 tex_index;      // 255 for no texture
+	u8 tex_layer;      // Layer of the texture inside its page
+	u8 color[4];       // Normalized RGBA8
+	u16 tex_coord[2];  // Normalized
+} vertex;
+
+#else
+
 typedef struct {
 	f32 position[3];
 	f32 color[4];
 	f32 tex_coord[2];
 	i32 tex_index; // -1 for invalid
+	i32 tex_layer;
 } vertex;
 
-#define MAX_QUADS 1000
-#define MAX_VERTICES (MAX_QUADS * 4)
-#define MAX_INDICES (MAX_QUADS * 6)
-#define MAX_TEXTURE_SLOTS 8
+#endif
+
+// Instanced mode writes one record per quad, the instanced vertex shader expands and rotates a unit quad
+typedef struct {
+	f32 center[2];
+	f32 size[2];
+	f32 rotation;      // Radians
+	f32 depth;
+	u16 uv_rect[4];    // Normalized u0, v0, u1, v1
+	u8 color[4];       // Normalized RGBA8
+	u8 tex_index;      // 255 for no texture
+	u8 tex_layer;
+	u8 padding[2];
+} quad_instance;
+
+// The vertex buffer is a ring of regions, each holding one batch. Quads are written straight into
+// the mapped region and a fence per region keeps the CPU from overwriting vertices the GPU still reads.
+// A region holds MAX_VERTICES vertices, or MAX_QUADS instances which always take less room.
+#define RENDERER_BUFFER_REGIONS 3
+#define RENDERER_REGION_SIZE (MAX_VERTICES * sizeof(vertex))
 
 typedef struct {
 	GLuint vao, vbo, ibo;
-	vertex* vertex_buffer_base;
-	vertex* vertex_buffer_ptr;
+	vertex* vertex_buffer_base;  // Quad n of the batch is written at vertex n * 4, or instance n
 	GLuint indices_count;
 	GLuint texture_slots[MAX_TEXTURE_SLOTS];
 	u32 texture_slot_index;
+    u32 slot_pages[MAX_TEXTURE_SLOTS];  // Page bound to each slot, the software backend samples pages by index
+
+    // A page is in the current batch if its batch id matches, which makes the slot lookup O(1)
+    u32 batch_id;
+    u32 page_batch_ids[TEXTURE_ARRAY_MAX_PAGES];
+    u8 page_slots[TEXTURE_ARRAY_MAX_PAGES];
+
+    u8 instanced;            // Quads go to the instance path instead of being expanded to vertices
+    GLuint instanced_vao;
+    GLuint corner_vbo;       // Unit quad corners shared by every instance
+    GLuint instanced_shader_program;
+
+    u8* persistent_map;      // Whole ring, mapped once when buffer storage is available, NULL otherwise
+    u8 region_mapped;        // The current region is mapped and must be unmapped before drawing
+    u32 region;              // Region the current batch is written to
+    GLsync region_fences[RENDERER_BUFFER_REGIONS];
+    u8 in_frame;             // Between renderer2D_begin_frame and renderer2D_end_frame
+    u8 deferred;             // Draw calls are recorded into the queue and expanded when it is flushed
+    u8 capturing;            // Calls of this frame are written to the frame capture
+    render_queue queue;
+    text_cache text_runs;    // Laid-out bitmap text, replayed while the string and font stay the same
+    struct quad_job* quad_jobs;  // MAX_QUADS entries, quads of a queued run resolved for expansion
+    renderer2D_frame_stats frame_stats;      // Frame being recorded
+    renderer2D_frame_stats last_frame_stats; // Last frame that ended
 
-    GLuint white_texture;
     GLuint shader_program;
 
+    u8 software;               // Batches are rasterized on the CPU, no GL call is made
+    vertex* software_vertices; // The one region of the software backend
+
     i32 screen_width, screen_height;
 
+    // Pixel art mode, the scene is drawn at logical resolution and upscaled to the window once per frame
+    i32 pixel_scale;                  // Window pixels per logical pixel, 1 draws straight to the window
+    i32 target_width, target_height;  // Logical resolution plus a pixel for the camera offset to move into
+    GLuint target_fbo, target_color, target_depth;
+    GLuint upscale_program, upscale_vao;
+    GLint upscale_offset_location;
+    u8* software_upscaled;            // Window sized frame the software target is upscaled into
+    i32* software_columns;            // Target column of each window column this frame
+
+    f32 camera_x, camera_y;           // Window pixel at the bottom left of the screen, from the next frame on
+    f32 view_origin[2];               // Added to vertex positions to get target pixels before the pixel scale
+    f32 camera_offset[2];             // Part of the camera below one logical pixel, moves the upscale instead
+
     // Matrices
     mat4 projection;
 } renderer2D_data;
 
 renderer2D_data renderer;
 
-u8 renderer2D_init(i32 width, i32 height) {
-    renderer.vertex_buffer_base = malloc(MAX_VERTICES * sizeof(vertex));
+static u8 internal_unorm8(f32 value) {
+    value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    return (u8)(value * 255.0f + 0.5f);
+}
 
-    glGenVertexArrays(1, &renderer.vao);
-    glBindVertexArray(renderer.vao);
+static u16 internal_unorm16(f32 value) {
+    value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    return (u16)(value * 65535.0f + 0.5f);
+}
+
+// Writes the four corners of a quad in the active vertex layout, attributes shared by the corners are converted once
+static void internal_write_quad(vertex* v, const f32 positions[4][2], f32 z, color4 color, const uv_rect* rect, i32 tex_index, i32 tex_layer) {
+#if RENDERER2D_PACKED_VERTICES
+    u16 depth = internal_unorm16(z / RENDERER_DEPTH_RANGE);
+    u8 packed_color[4] = { internal_unorm8(color.r), internal_unorm8(color.g), internal_unorm8(color.b), internal_unorm8(color.a) };
+    u8 packed_tex_index = tex_index < 0 ? 255 : (u8)tex_index;
+    u16 u0 = internal_unorm16(rect->u0), v0 = internal_unorm16(rect->v0);
+    u16 u1 = internal_unorm16(rect->u1), v1 = internal_unorm16(rect->v1);
+    u16 tex_coords[4][2] = { { u0, v0 }, { u1, v0 }, { u1, v1 }, { u0, v1 } };
+
+    for (int i = 0; i < 4; i++, v++) {
+        v->position[0] = positions[i][0];
+        v->position[1] = positions[i][1];
+        v->depth = depth;
+        v->tex_index = packed_tex_index;
+        v->tex_layer = (u8)tex_layer;
+        memcpy(v->color, packed_color, sizeof(packed_color));
+        v->tex_coord[0] = tex_coords[i][0];
+        v->tex_coord[1] = tex_coords[i][1];
+    }
+#else
+    f32 tex_coords[4][2] = {
+        { rect->u0, rect->v0 },
+        { rect->u1, rect->v0 },
+        { rect->u1, rect->v1 },
+        { rect->u0, rect->v1 }
+    };
+
+    for (int i = 0; i < 4; i++, v++) {
+        v->position[0] = positions[i][0];
+        v->position[1] = positions[i][1];
+        v->position[2] = z;
+        memcpy(v->color, &color.r, 4 * sizeof(f32));
+        memcpy(v->tex_coord, tex_coords[i], 2 * sizeof(f32));
+        v->tex_index = tex_index;
+        v->tex_layer = tex_layer;
+    }
+#endif
+}
+
+// Hands the quads of a batch to the software rasterizer, decoded from the vertex layout so every path that writes
+// vertices draws the same on both backends
+static void internal_rasterize_quads(const vertex* vertices, u32 quad_count, const u32* slot_pages) {
+    f32 inverse_scale = 1.0f / (f32)renderer.pixel_scale;
+
+    for (u32 i = 0; i < quad_count; i++) {
+        const vertex* v = vertices + (size_t)i * 4;
+
+        software_quad quad;
+        for (int corner = 0; corner < 4; corner++) {
+            quad.corners[corner][0] = (v[corner].position[0] + renderer.view_origin[0]) * inverse_scale;
+            quad.corners[corner][1] = (v[corner].position[1] + renderer.view_origin[1]) * inverse_scale;
+        }
+
+#if RENDERER2D_PACKED_VERTICES
+        quad.z = v->depth / 65535.0f * RENDERER_DEPTH_RANGE;
+        memcpy(quad.color, v->color, sizeof(quad.color));
+        quad.rect = (uv_rect){ v[0].tex_coord[0] / 65535.0f, v[0].tex_coord[1] / 65535.0f,
+                               v[2].tex_coord[0] / 65535.0f, v[2].tex_coord[1] / 65535.0f };
+        i32 tex_index = v->tex_index;
+#else
+        quad.z = v->position[2];
+        for (int c = 0; c < 4; c++) {
+            quad.color[c] = internal_unorm8(v->color[c]);
+        }
+        quad.rect = (uv_rect){ v[0].tex_coord[0], v[0].tex_coord[1], v[2].tex_coord[0], v[2].tex_coord[1] };
+        i32 tex_index = v->tex_index;
+#endif
+
+        quad.texels = NULL;
+        quad.texture_size = 0;
+        if (tex_index >= 0 && tex_index < MAX_TEXTURE_SLOTS) {
+            quad.texels = texture_array_page_pixels(slot_pages[tex_index], (u32)v->tex_layer, &quad.texture_size);
+        }
+
+        software_rasterizer_submit(&quad);
+    }
+}
+
+// Waits for the GPU to finish reading the region and points the batch at it
+static void internal_map_region() {
+    if (renderer.software) {
+        renderer.vertex_buffer_base = renderer.software_vertices;
+        return;
+    }
+
+    GLsync fence = renderer.region_fences[renderer.region];
+    if (fence) {
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {
+            // Keep waiting, the GPU is more than RENDERER_BUFFER_REGIONS batches behind
+        }
+        glDeleteSync(fence);
+        renderer.region_fences[renderer.region] = NULL;
+    }
+
+    if (renderer.persistent_map) {
+        renderer.vertex_buffer_base = (vertex*)(renderer.persistent_map + (size_t)renderer.region * RENDERER_REGION_SIZE);
+    }
+    else if (!renderer.region_mapped) {
+        // The fence already guarantees the region is free, so the driver doesn't need to synchronize
+        glBindBuffer(GL_ARRAY_BUFFER, renderer.vbo);
+        renderer.vertex_buffer_base = (vertex*)glMapBufferRange(GL_ARRAY_BUFFER,
+            (GLintptr)((size_t)renderer.region * RENDERER_REGION_SIZE), RENDERER_REGION_SIZE,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        renderer.region_mapped = true;
+    }
+}
+
+// Instance attributes point at the region of the current batch, so they are set right before drawing
+static void internal_bind_instance_region() {
+    const u8* base = (const u8*)((size_t)renderer.region * RENDERER_REGION_SIZE);
+    GLsizei stride = sizeof(quad_instance);
 
-    glGenBuffers(1, &renderer.vbo);
     glBindBuffer(GL_ARRAY_BUFFER, renderer.vbo);
-    glBufferData(GL_ARRAY_BUFFER, MAX_VERTICES * sizeof(vertex), NULL, GL_STATIC_DRAW); // fill later
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, base + offsetof(quad_instance, center));
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, base + offsetof(quad_instance, size));
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, stride, base + offsetof(quad_instance, rotation)); // Rotation and depth
+    glVertexAttribPointer(4, 4, GL_UNSIGNED_SHORT, GL_TRUE, stride, base + offsetof(quad_instance, uv_rect));
+    glVertexAttribPointer(5, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, base + offsetof(quad_instance, color));
+    glVertexAttribIPointer(6, 1, GL_UNSIGNED_BYTE, stride, base + offsetof(quad_instance, tex_index));
+    glVertexAttribIPointer(7, 1, GL_UNSIGNED_BYTE, stride, base + offsetof(quad_instance, tex_layer));
+}
+
+// Draws the current batch out of its region and moves on to the next region
+static void internal_draw_batch(renderer2D_flush_reason reason) {
+    renderer2D_end_batch();
+
+    if (renderer.indices_count == 0) return;
+
+    renderer.frame_stats.draw_calls++;
+    renderer.frame_stats.quads += renderer.indices_count / 6;
+    renderer.frame_stats.flushes[reason]++;
+
+    if (renderer.software) {
+        internal_rasterize_quads(renderer.vertex_buffer_base, renderer.indices_count / 6, renderer.slot_pages);
+        renderer.indices_count = 0;
+        return;
+    }
 
+    if (renderer.instanced) {
+        glUseProgram(renderer.instanced_shader_program);
+        glBindVertexArray(renderer.instanced_vao);
+        internal_bind_instance_region();
+    }
+    else {
+        glUseProgram(renderer.shader_program); // Use the shaders from earlier in drawing
+        glBindVertexArray(renderer.vao); // Use the quad vertices in the buffer
+    }
+
+    for (u32 i = 0; i < renderer.texture_slot_index; i++) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, renderer.texture_slots[i]);
+    }
+
+    if (renderer.instanced) {
+        glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, NULL, (GLsizei)(renderer.indices_count / 6));
+    }
+    else {
+        // Indices are shared by every region, the base vertex selects the region
+        glDrawElementsBaseVertex(GL_TRIANGLES, renderer.indices_count, GL_UNSIGNED_INT, NULL, (GLint)(renderer.region * MAX_VERTICES));
+    }
+
+    renderer.region_fences[renderer.region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    renderer.region = (renderer.region + 1) % RENDERER_BUFFER_REGIONS;
+    renderer.indices_count = 0;
+}
+
+// Called when a batch is full in the middle of a frame
+static void internal_next_batch(renderer2D_flush_reason reason) {
+    internal_draw_batch(reason);
+    renderer2D_begin_batch();
+}
+
+// Remaps a uv rect of the texture into the area the texture covers in its layer
+static void internal_map_texture_rect(const texture_array_entry* entry, const uv_rect* rect, uv_rect* out_rect) {
+    f32 scale_u = entry->rect.u1 - entry->rect.u0;
+    f32 scale_v = entry->rect.v1 - entry->rect.v0;
+    out_rect->u0 = entry->rect.u0 + rect->u0 * scale_u;
+    out_rect->v0 = entry->rect.v0 + rect->v0 * scale_v;
+    out_rect->u1 = entry->rect.u0 + rect->u1 * scale_u;
+    out_rect->v1 = entry->rect.v0 + rect->v1 * scale_v;
+}
+
+// Finds the batch slot of the page a texture lives in, false if the page isn't bound and every slot is taken.
+// The uv rect is remapped into the area the texture covers in its layer.
+static u8 internal_try_resolve_texture(i32 texture, const uv_rect* rect, uv_rect* out_rect, i32* out_layer, i32* out_index) {
+    const texture_array_entry* entry = texture_array_get(texture);
+    if (!entry) {
+        *out_rect = *rect;
+        *out_layer = 0;
+        *out_index = -1; // No texture, the quad is drawn with its color only
+        return true;
+    }
+
+    internal_map_texture_rect(entry, rect, out_rect);
+    *out_layer = entry->layer;
+
+    if (renderer.page_batch_ids[entry->page] == renderer.batch_id) {
+        *out_index = renderer.page_slots[entry->page];
+        return true;
+    }
+
+    if (renderer.texture_slot_index >= MAX_TEXTURE_SLOTS) return false;
+
+    u8 slot = (u8)renderer.texture_slot_index++;
+    renderer.texture_slots[slot] = texture_array_page_texture(entry->page);
+    renderer.slot_pages[slot] = entry->page;
+    renderer.page_batch_ids[entry->page] = renderer.batch_id;
+    renderer.page_slots[entry->page] = slot;
+    *out_index = slot;
+    return true;
+}
+
+// Same as above, but starts a new batch when every slot is taken
+static i32 internal_resolve_texture(i32 texture, const uv_rect* rect, uv_rect* out_rect, i32* out_layer) {
+    i32 tex_index = -1;
+    if (!internal_try_resolve_texture(texture, rect, out_rect, out_layer, &tex_index)) {
+        internal_next_batch(RENDERER2D_FLUSH_TEXTURE_SLOTS);
+        internal_try_resolve_texture(texture, rect, out_rect, out_layer, &tex_index);
+    }
+    return tex_index;
+}
+
+// Writes quad number quad of the batch, the texture is already resolved. Vertex mode expands the quad on the CPU
+// (trig only for rotated quads), instanced mode stores a single record and leaves the expansion to the GPU.
+// Only reads the renderer state, so disjoint quads can be written from several threads at once.
+static void internal_expand_quad(u32 quad, f32 x, f32 y, f32 width, f32 height, f32 rotation_rad, const uv_rect* rect, color4 color, i32 tex_index, i32 tex_layer, f32 z) {
+    f32 x_offset = -renderer.screen_width / 2.0f;
+    f32 y_offset = -renderer.screen_height / 2.0f;
+
+    if (renderer.instanced) {
+        quad_instance* instance = (quad_instance*)renderer.vertex_buffer_base + quad;
+        instance->center[0] = x + x_offset;
+        instance->center[1] = y + y_offset;
+        instance->size[0] = width;
+        instance->size[1] = height;
+        instance->rotation = rotation_rad;
+        instance->depth = z;
+        instance->uv_rect[0] = internal_unorm16(rect->u0);
+        instance->uv_rect[1] = internal_unorm16(rect->v0);
+        instance->uv_rect[2] = internal_unorm16(rect->u1);
+        instance->uv_rect[3] = internal_unorm16(rect->v1);
+        instance->color[0] = internal_unorm8(color.r);
+        instance->color[1] = internal_unorm8(color.g);
+        instance->color[2] = internal_unorm8(color.b);
+        instance->color[3] = internal_unorm8(color.a);
+        instance->tex_index = tex_index < 0 ? 255 : (u8)tex_index;
+        instance->tex_layer = (u8)tex_layer;
+        memset(instance->padding, 0, sizeof(instance->padding));
+        return;
+    }
+
+    // Same kernel as the bulk paths so a quad comes out identical whichever way it was drawn
+    f32 positions[4][2];
+    quad_kernel_corners(&x, &y, &width, &height, &rotation_rad, 1, x_offset, y_offset, &positions);
+
+    internal_write_quad(renderer.vertex_buffer_base + (size_t)quad * 4, positions, z, color, rect, tex_index, tex_layer);
+}
+
+// Every immediate draw ends up here
+static void internal_submit_quad(f32 x, f32 y, f32 width, f32 height, f32 rotation_rad, const uv_rect* rect, color4 color, i32 texture_slot, f32 z) {
+    if (renderer.indices_count >= MAX_INDICES) {
+        internal_next_batch(RENDERER2D_FLUSH_QUAD_LIMIT); // If we add more indices now, we will have more than the max allowed, so flush, then continue
+    }
+
+    uv_rect layer_rect;
+    i32 tex_layer = 0;
+    i32 tex_index = internal_resolve_texture(texture_slot, rect, &layer_rect, &tex_layer);
+
+    internal_expand_quad(renderer.indices_count / 6, x, y, width, height, rotation_rad, &layer_rect, color, tex_index, tex_layer, z);
+    renderer.indices_count += 6;
+}
+
+// A quad with its texture resolved, expanded later by whichever thread gets its range
+typedef struct quad_job {
+    f32 x, y, width, height;
+    f32 rotation;
+    f32 z;
+    color4 color;
+    uv_rect rect;  // Mapped into the texture's layer
+    i32 tex_index;
+    i32 tex_layer;
+} quad_job;
+
+typedef struct {
+    u32 first_quad;  // Batch position of quad_jobs[0]
+} quad_job_range;
+
+// Vertex mode gathers the range into SoA chunks for the SIMD corner kernel, instanced mode has no corners to compute
+static void internal_expand_quad_range(void* data, u32 begin, u32 end) {
+    const quad_job_range* range = (const quad_job_range*)data;
+
+    if (renderer.instanced) {
+        for (u32 i = begin; i < end; i++) {
+            const quad_job* job = &renderer.quad_jobs[i];
+            internal_expand_quad(range->first_quad + i, job->x, job->y, job->width, job->height, job->rotation,
+                                 &job->rect, job->color, job->tex_index, job->tex_layer, job->z);
+        }
+        return;
+    }
+
+    f32 x_offset = -renderer.screen_width / 2.0f;
+    f32 y_offset = -renderer.screen_height / 2.0f;
+
+    f32 x[QUAD_KERNEL_CHUNK], y[QUAD_KERNEL_CHUNK], width[QUAD_KERNEL_CHUNK], height[QUAD_KERNEL_CHUNK], rotation[QUAD_KERNEL_CHUNK];
+    f32 corners[QUAD_KERNEL_CHUNK][4][2];
+
+    for (u32 chunk = begin; chunk < end; chunk += QUAD_KERNEL_CHUNK) {
+        u32 count = end - chunk < QUAD_KERNEL_CHUNK ? end - chunk : QUAD_KERNEL_CHUNK;
+
+        for (u32 i = 0; i < count; i++) {
+            const quad_job* job = &renderer.quad_jobs[chunk + i];
+            x[i] = job->x;
+            y[i] = job->y;
+            width[i] = job->width;
+            height[i] = job->height;
+            rotation[i] = job->rotation;
+        }
+
+        quad_kernel_corners(x, y, width, height, rotation, count, x_offset, y_offset, corners);
+
+        for (u32 i = 0; i < count; i++) {
+            const quad_job* job = &renderer.quad_jobs[chunk + i];
+            vertex* v = renderer.vertex_buffer_base + (size_t)(range->first_quad + chunk + i) * 4;
+            internal_write_quad(v, corners[i], job->z, job->color, &job->rect, job->tex_index, job->tex_layer);
+        }
+    }
+}
+
+// Writes the first count jobs to the batch after its current quads, splitting them across the workers when there
+// are enough of them. The textures were resolved in order beforehand so the result doesn't depend on the workers.
+static void internal_expand_jobs(u32 count, u8 slots_full) {
+    quad_job_range range = { renderer.indices_count / 6 };
+    if (count >= RENDERER_PARALLEL_MIN_QUADS && job_system_thread_count() > 1) {
+        job_system_parallel_for(count, RENDERER_PARALLEL_GRAIN, internal_expand_quad_range, &range);
+    }
+    else {
+        internal_expand_quad_range(&range, 0, count);
+    }
+
+    renderer.indices_count += count * 6;
+
+    if (slots_full) {
+        internal_next_batch(RENDERER2D_FLUSH_TEXTURE_SLOTS);
+    }
+}
+
+// Expands consecutive queued quads starting at sorted index first, up to the end of the current batch
+static u32 internal_expand_quad_run(const render_queue* queue, u32 first) {
+    if (renderer.indices_count >= MAX_INDICES) {
+        internal_next_batch(RENDERER2D_FLUSH_QUAD_LIMIT);
+    }
+
+    u32 room = MAX_QUADS - renderer.indices_count / 6;
+    u32 count = 0;
+    u8 slots_full = false;
+
+    u32 i = first;
+    while (i < queue->count && count < room) {
+        const render_command* command = render_queue_get(queue, i);
+        if (command->type != RENDER_COMMAND_QUAD) break;
+
+        quad_job* job = &renderer.quad_jobs[count];
+        if (!internal_try_resolve_texture(command->quad.texture, &command->quad.rect, &job->rect, &job->tex_layer, &job->tex_index)) {
+            slots_full = true;
+            break;
+        }
+
+        job->x = command->quad.x;
+        job->y = command->quad.y;
+        job->width = command->quad.width;
+        job->height = command->quad.height;
+        job->rotation = command->quad.rotation;
+        job->z = command->z;
+        job->color = command->color;
+        count++;
+        i++;
+    }
+
+    internal_expand_jobs(count, slots_full);
+    return i;
+}
+
+static GLuint internal_load_program(const char* vertex_path, const char* fragment_path) {
+    // Load in shaders from their respective files
+    char* vertex_shader_source = read_shader_source(vertex_path);
+    if (vertex_shader_source == NULL) return 0;
+
+    char* fragment_shader_source = read_shader_source(fragment_path);
+    if (fragment_shader_source == NULL) {
+        free_shader_source(vertex_shader_source);
+        return 0;
+    }
+
+    GLuint program = create_shader_program(vertex_shader_source, fragment_shader_source);
+
+    // Free up memory allocated earlier by read_shader_source because we don't need it anymore
+    free_shader_source(vertex_shader_source);
+    free_shader_source(fragment_shader_source);
+
+    if (!program) return 0;
+
+    glUseProgram(program);
+
+    // Setup u_Textures[0..7]
+    GLint samplers[8] = { 0,1,2,3,4,5,6,7 };
+    glUniform1iv(glGetUniformLocation(program, "u_Textures"), 8, samplers);
+
+    // Upload it to the shader
+    glUniformMatrix4fv(glGetUniformLocation(program, "uProjection"), 1, GL_FALSE, &renderer.projection.r[0][0]);
+
+    return program;
+}
+
+// Points the attributes of the bound vertex array at the bound buffer, laid out as vertex
+static void internal_set_vertex_layout() {
+    // aPosition, aDepth, aColor, aTexCoord, aTexIndex, aTexLayer
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (const void*)offsetof(vertex, position));
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(vertex), (const void*)offsetof(vertex, position));
 
     glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(vertex), (const void*)offsetof(vertex, color));
-
     glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(vertex), (const void*)offsetof(vertex, tex_coord));
-
     glEnableVertexAttribArray(3);
-    glVertexAttribIPointer(3, 1, GL_INT, sizeof(vertex), (const void*)offsetof(vertex, tex_index));
+    glEnableVertexAttribArray(4);
+    glEnableVertexAttribArray(5);
+
+#if RENDERER2D_PACKED_VERTICES
+    glVertexAttribPointer(1, 1, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(vertex), (const void*)offsetof(vertex, depth));
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(vertex), (const void*)offsetof(vertex, color));
+    glVertexAttribPointer(3, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(vertex), (const void*)offsetof(vertex, tex_coord));
+    glVertexAttribIPointer(4, 1, GL_UNSIGNED_BYTE, sizeof(vertex), (const void*)offsetof(vertex, tex_index));
+    glVertexAttribIPointer(5, 1, GL_UNSIGNED_BYTE, sizeof(vertex), (const void*)offsetof(vertex, tex_layer));
+#else
+    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(vertex), (const void*)(offsetof(vertex, position) + 2 * sizeof(f32)));
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(vertex), (const void*)offsetof(vertex, color));
+    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(vertex), (const void*)offsetof(vertex, tex_coord));
+    glVertexAttribIPointer(4, 1, GL_INT, sizeof(vertex), (const void*)offsetof(vertex, tex_index));
+    glVertexAttribIPointer(5, 1, GL_INT, sizeof(vertex), (const void*)offsetof(vertex, tex_layer));
+#endif
+}
+
+// Buffers, shaders and state of the OpenGL backend
+static u8 internal_init_opengl() {
+    glGenVertexArrays(1, &renderer.vao);
+    glBindVertexArray(renderer.vao);
+
+    glGenBuffers(1, &renderer.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, renderer.vbo);
+
+    GLsizeiptr ring_size = (GLsizeiptr)RENDERER_BUFFER_REGIONS * RENDERER_REGION_SIZE;
+    if (GLAD_GL_VERSION_4_4) {
+        // Mapped once for the lifetime of the renderer, coherent so no explicit flushes are needed
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, ring_size, NULL, flags);
+        renderer.persistent_map = (u8*)glMapBufferRange(GL_ARRAY_BUFFER, 0, ring_size, flags);
+    }
+    else {
+        glBufferData(GL_ARRAY_BUFFER, ring_size, NULL, GL_STREAM_DRAW);
+    }
+
+    internal_set_vertex_layout();
 
     // Index buffer setup
     GLuint* indices = malloc(MAX_INDICES * sizeof(GLuint));
@@ -84,53 +624,51 @@ u8 renderer2D_init(i32 width, i32 height) {
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, MAX_INDICES * sizeof(GLuint), indices, GL_STATIC_DRAW);
     free(indices);
 
-    // White texture
-    glGenTextures(1, &renderer.white_texture);
-    glBindTexture(GL_TEXTURE_2D, renderer.white_texture);
-    uint32_t white = 0xFFFFFFFF;
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &white);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    renderer.texture_slots[0] = renderer.white_texture;
-
-    // Shaders & program
-
-    // Load in shaders from their respective files
-    char* vertex_shader_source = read_shader_source("D:/Programming/C/Quartz2D/Quartz2D/src/renderer/shaders/vertex_shader.glsl");
-    if (vertex_shader_source == NULL) {
-        renderer2D_shutdown();
-        return false;
-    }
+    // Instanced path, the unit quad uses the first six indices and the instance attributes step once per quad
+    glGenVertexArrays(1, &renderer.instanced_vao);
+    glBindVertexArray(renderer.instanced_vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderer.ibo);
 
-    char* fragment_shader_source = read_shader_source("D:/Programming/C/Quartz2D/Quartz2D/src/renderer/shaders/fragment_shader.glsl");
-    if (fragment_shader_source == NULL) {
-        renderer2D_shutdown();
-        return false;
-    }
+    f32 corners[4][2] = {
+        { -0.5f, -0.5f },
+        {  0.5f, -0.5f },
+        {  0.5f,  0.5f },
+        { -0.5f,  0.5f }
+    };
 
-    renderer.shader_program = create_shader_program(vertex_shader_source, fragment_shader_source);
-    glUseProgram(renderer.shader_program);
+    glGenBuffers(1, &renderer.corner_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, renderer.corner_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
 
-    // Free up memory allocated earlier by read_shader_source because we don't need it anymore
-    free_shader_source(vertex_shader_source);
-    free_shader_source(fragment_shader_source);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(f32), NULL);
 
-    // Setup u_Textures[0..7]
-    GLint samplers[8] = { 0,1,2,3,4,5,6,7 };
-    glUniform1iv(glGetUniformLocation(renderer.shader_program, "u_Textures"), 8, samplers);
+    for (GLuint attribute = 1; attribute <= 7; attribute++) {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
 
-    renderer.screen_width = width;
-    renderer.screen_height = height;
+    glBindVertexArray(renderer.vao);
 
     glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
     glViewport(0, 0, renderer.screen_width, renderer.screen_height);
 
-    renderer.projection = mat4_orthographic_rh((f32)renderer.screen_width, (f32)renderer.screen_height, 0.001f, 100.0f);
+    // Shaders & program
+    renderer.shader_program = internal_load_program("D:/Programming/C/Quartz2D/Quartz2D/src/renderer/shaders/vertex_shader.glsl",
+                                                    "D:/Programming/C/Quartz2D/Quartz2D/src/renderer/shaders/fragment_shader.glsl");
+    if (!renderer.shader_program) return false;
+
+    renderer.instanced_shader_program = internal_load_program("D:/Programming/C/Quartz2D/Quartz2D/src/renderer/shaders/instanced_vertex_shader.glsl",
+                                                              "D:/Programming/C/Quartz2D/Quartz2D/src/renderer/shaders/fragment_shader.glsl");
+    if (!renderer.instanced_shader_program) return false;
 
-    // Upload it to the shader
-    GLint loc = glGetUniformLocation(renderer.shader_program, "uProjection");
     glUseProgram(renderer.shader_program);
-    glUniformMatrix4fv(loc, 1, GL_FALSE, &renderer.projection.r[0][0]);
+
+#if RENDERER2D_PACKED_VERTICES
+    glUniform1f(glGetUniformLocation(renderer.shader_program, "uDepthScale"), RENDERER_DEPTH_RANGE);
+#else
+    glUniform1f(glGetUniformLocation(renderer.shader_program, "uDepthScale"), 1.0f);
+#endif
 
     // Turn on blending for transparency
     glEnable(GL_BLEND);
@@ -143,263 +681,532 @@ u8 renderer2D_init(i32 width, i32 height) {
     return true;
 }
 
-void renderer2D_draw_quad(f32 x, f32 y, f32 width, f32 height, i32 texture_slot, color4 color, f32 z) {
-    if (renderer.indices_count >= MAX_INDICES) {
-        renderer2D_flush(); // If we add more indices now, we will have more than the max allowed, so flush, then continue
+static void internal_destroy_pixel_target() {
+    if (renderer.target_fbo) glDeleteFramebuffers(1, &renderer.target_fbo);
+    if (renderer.target_color) glDeleteTextures(1, &renderer.target_color);
+    if (renderer.target_depth) glDeleteRenderbuffers(1, &renderer.target_depth);
+    renderer.target_fbo = 0;
+    renderer.target_color = 0;
+    renderer.target_depth = 0;
+}
+
+// Framebuffer the scene is drawn to in pixel art mode, a scale of 1 only releases the current one
+static u8 internal_create_pixel_target(i32 scale, i32 width, i32 height) {
+    internal_destroy_pixel_target();
+    if (scale == 1) return true;
+
+    if (!renderer.upscale_program) {
+        renderer.upscale_program = internal_load_program("D:/Programming/C/Quartz2D/Quartz2D/src/renderer/shaders/upscale_vertex_shader.glsl",
+                                                         "D:/Programming/C/Quartz2D/Quartz2D/src/renderer/shaders/upscale_fragment_shader.glsl");
+        if (!renderer.upscale_program) return false;
+
+        glUniform1i(glGetUniformLocation(renderer.upscale_program, "uTarget"), 0);
+        renderer.upscale_offset_location = glGetUniformLocation(renderer.upscale_program, "uOffset");
+        glGenVertexArrays(1, &renderer.upscale_vao); // The triangle comes from gl_VertexID, core profile still wants a vertex array
     }
 
-    i32 tex_index = -1; // default to white texture
+    glUseProgram(renderer.upscale_program);
+    glUniform1f(glGetUniformLocation(renderer.upscale_program, "uScale"), (f32)scale);
 
-    if (texture_slot != -1) {
-        for (uint32_t i = 1; i < renderer.texture_slot_index; i++) {
-            if (renderer.texture_slots[i] == texture_slot) {
-                tex_index = i;
-                break;
-            }
-        }
+    glGenTextures(1, &renderer.target_color);
+    glBindTexture(GL_TEXTURE_2D, renderer.target_color);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-        if (tex_index == -1) {
-            if (renderer.texture_slot_index >= MAX_TEXTURE_SLOTS) {
-                renderer2D_flush();
-                renderer2D_begin_batch();
-            }
+    glGenRenderbuffers(1, &renderer.target_depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderer.target_depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
 
-            tex_index = (i32)renderer.texture_slot_index;
-            renderer.texture_slots[renderer.texture_slot_index++] = (GLuint)texture_slot;
-        }
+    glGenFramebuffers(1, &renderer.target_fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, renderer.target_fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, renderer.target_color, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderer.target_depth);
+
+    u8 complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return complete;
+}
+
+// The software rasterizer is sized to the target, upscaled frames go to a window sized buffer
+static u8 internal_create_software_target(i32 scale, i32 width, i32 height) {
+    software_rasterizer_shutdown();
+    free(renderer.software_upscaled);
+    free(renderer.software_columns);
+    renderer.software_upscaled = NULL;
+    renderer.software_columns = NULL;
+
+    if (!software_rasterizer_init(width, height)) return false;
+    if (scale == 1) return true;
+
+    renderer.software_upscaled = (u8*)malloc((size_t)renderer.screen_width * renderer.screen_height * 4);
+    renderer.software_columns = (i32*)malloc(sizeof(i32) * renderer.screen_width);
+    return renderer.software_upscaled && renderer.software_columns;
+}
+
+// Snaps the camera to whole logical pixels for the scene, what is left of it shifts the upscale
+static void internal_update_view() {
+    f32 scale = (f32)renderer.pixel_scale;
+    f32 view_x = renderer.camera_x;
+    f32 view_y = renderer.camera_y;
+    if (renderer.pixel_scale > 1) {
+        view_x = floorf(view_x / scale) * scale;
+        view_y = floorf(view_y / scale) * scale;
     }
 
-    f32 x_offset = -renderer.screen_width / 2.0f;
-    f32 y_offset = -renderer.screen_height / 2.0f;
+    renderer.camera_offset[0] = renderer.camera_x - view_x;
+    renderer.camera_offset[1] = renderer.camera_y - view_y;
+    renderer.view_origin[0] = renderer.screen_width / 2.0f - view_x;
+    renderer.view_origin[1] = renderer.screen_height / 2.0f - view_y;
 
-    f32 hw = width * 0.5f;
-    f32 hh = height * 0.5f;
+    if (renderer.software) return;
 
-    f32 positions[4][2] = {
-        { x - hw + x_offset, y - hh + y_offset },
-        { x + hw + x_offset, y - hh + y_offset },
-        { x + hw + x_offset, y + hh + y_offset },
-        { x - hw + x_offset, y + hh + y_offset }
-    };
+    // Vertices are relative to the window center, this maps them onto the whole target
+    mat4 projection = mat4_orthographic_rh((f32)renderer.target_width * scale, (f32)renderer.target_height * scale, 0.001f, RENDERER_DEPTH_RANGE);
+    projection.r[3][0] = projection.r[0][0] * renderer.view_origin[0] - 1.0f;
+    projection.r[3][1] = projection.r[1][1] * renderer.view_origin[1] - 1.0f;
 
-    f32 tex_coords[4][2] = {
-        { 0.0f, 0.0f },
-        { 1.0f, 0.0f },
-        { 1.0f, 1.0f },
-        { 0.0f, 1.0f }
-    };
+    if (memcmp(&projection, &renderer.projection, sizeof(mat4)) != 0) {
+        renderer.projection = projection;
+        glUseProgram(renderer.shader_program);
+        glUniformMatrix4fv(glGetUniformLocation(renderer.shader_program, "uProjection"), 1, GL_FALSE, &renderer.projection.r[0][0]);
+        glUseProgram(renderer.instanced_shader_program);
+        glUniformMatrix4fv(glGetUniformLocation(renderer.instanced_shader_program, "uProjection"), 1, GL_FALSE, &renderer.projection.r[0][0]);
+    }
+}
+
+// Draws the target over the whole window, every window pixel copies the logical pixel under it
+static void internal_upscale_target() {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, renderer.screen_width, renderer.screen_height);
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+
+    glUseProgram(renderer.upscale_program);
+    glUniform2f(renderer.upscale_offset_location, renderer.camera_offset[0], renderer.camera_offset[1]);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, renderer.target_color);
+    glBindVertexArray(renderer.upscale_vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBindVertexArray(renderer.vao);
+}
+
+// Same mapping as the upscale shader, window pixel centers divided down to the target
+static void internal_upscale_software() {
+    const u8* target = software_rasterizer_pixels();
+    u8* window = renderer.software_upscaled;
+    f32 scale = (f32)renderer.pixel_scale;
+    size_t row_size = (size_t)renderer.screen_width * 4;
 
-    for (int i = 0; i < 4; i++) {
-        renderer.vertex_buffer_ptr->position[0] = positions[i][0];
-        renderer.vertex_buffer_ptr->position[1] = positions[i][1];
-        renderer.vertex_buffer_ptr->position[2] = z;
-        memcpy(renderer.vertex_buffer_ptr->color, &color.r, 4 * sizeof(f32));
-        memcpy(renderer.vertex_buffer_ptr->tex_coord, tex_coords[i], 2 * sizeof(f32));
-        renderer.vertex_buffer_ptr->tex_index = tex_index;
-        renderer.vertex_buffer_ptr++;
+    for (i32 x = 0; x < renderer.screen_width; x++) {
+        renderer.software_columns[x] = (i32)(((f32)x + 0.5f + renderer.camera_offset[0]) / scale);
     }
 
-    renderer.indices_count += 6;
+    i32 previous_row = -1;
+    for (i32 y = 0; y < renderer.screen_height; y++) {
+        i32 row = (i32)(((f32)y + 0.5f + renderer.camera_offset[1]) / scale);
+        u8* out = window + (size_t)y * row_size;
+
+        if (row == previous_row) {
+            memcpy(out, out - row_size, row_size); // Same logical row as the window row below
+            continue;
+        }
+
+        const u8* in = target + (size_t)row * renderer.target_width * 4;
+        for (i32 x = 0; x < renderer.screen_width; x++) {
+            memcpy(out + (size_t)x * 4, in + (size_t)renderer.software_columns[x] * 4, 4);
+        }
+        previous_row = row;
+    }
 }
 
-void renderer2D_draw_quad_atlas(f32 x, f32 y, f32 width, f32 height, i32 texture_slot, const uv_rect* rect, color4 color, f32 z) {
-    if (renderer.indices_count >= MAX_INDICES) {
-        renderer2D_flush();
-        renderer2D_begin_batch();
+u8 renderer2D_init(i32 width, i32 height) {
+    return renderer2D_init_backend(width, height, RENDERER2D_BACKEND_OPENGL);
+}
+
+u8 renderer2D_init_backend(i32 width, i32 height, renderer2D_backend backend) {
+    renderer.software = backend == RENDERER2D_BACKEND_SOFTWARE;
+    renderer.screen_width = width;
+    renderer.screen_height = height;
+    renderer.pixel_scale = 1;
+    renderer.target_width = width;
+    renderer.target_height = height;
+    renderer.camera_x = 0.0f;
+    renderer.camera_y = 0.0f;
+    renderer.projection = mat4_orthographic_rh((f32)renderer.screen_width, (f32)renderer.screen_height, 0.001f, RENDERER_DEPTH_RANGE);
+
+    render_queue_init(&renderer.queue);
+    text_cache_init(&renderer.text_runs);
+
+    renderer.quad_jobs = malloc(sizeof(quad_job) * MAX_QUADS);
+    if (!renderer.quad_jobs) {
+        renderer2D_shutdown();
+        return false;
     }
 
-    i32 tex_index = -1;
+    // Texture pages, untextured quads skip sampling so no white texture is needed
+    if (!texture_array_init(renderer.software)) {
+        renderer2D_shutdown();
+        return false;
+    }
+
+    if (renderer.software) {
+        // A batch is rasterized before the next one is written, so one region is enough
+        renderer.software_vertices = (vertex*)malloc(RENDERER_REGION_SIZE);
+        if (!renderer.software_vertices || !software_rasterizer_init(width, height)) {
+            renderer2D_shutdown();
+            return false;
+        }
+        return true;
+    }
+
+    if (!internal_init_opengl()) {
+        renderer2D_shutdown();
+        return false;
+    }
 
-    if (texture_slot != -1) {
-        for (u32 i = 1; i < renderer.texture_slot_index; i++) {
-            if (renderer.texture_slots[i] == (GLuint)texture_slot) {
-                tex_index = (i32)i;
+    return true;
+}
+
+// Writes sprites straight into the batch, expanding as many per run as the batch has room for
+static void internal_submit_sprites(const sprite_instance* sprites, u32 count) {
+    u32 i = 0;
+    while (i < count) {
+        if (renderer.indices_count >= MAX_INDICES) {
+            internal_next_batch(RENDERER2D_FLUSH_QUAD_LIMIT);
+        }
+
+        u32 room = MAX_QUADS - renderer.indices_count / 6;
+        u32 jobs = 0;
+        u8 slots_full = false;
+
+        while (i < count && jobs < room) {
+            const sprite_instance* sprite = &sprites[i];
+
+            quad_job* job = &renderer.quad_jobs[jobs];
+            if (!internal_try_resolve_texture(sprite->texture, &sprite->rect, &job->rect, &job->tex_layer, &job->tex_index)) {
+                slots_full = true;
                 break;
             }
+
+            job->x = sprite->x;
+            job->y = sprite->y;
+            job->width = sprite->width;
+            job->height = sprite->height;
+            job->rotation = sprite->rotation;
+            job->z = sprite->z;
+            job->color = sprite->color;
+            jobs++;
+            i++;
         }
 
-        if (tex_index == -1) {
-            if (renderer.texture_slot_index >= MAX_TEXTURE_SLOTS) {
-                renderer2D_flush();
-                renderer2D_begin_batch();
-            }
+        internal_expand_jobs(jobs, slots_full);
+    }
+}
 
-            tex_index = (i32)renderer.texture_slot_index;
-            renderer.texture_slots[renderer.texture_slot_index++] = (GLuint)texture_slot;
+// Lays the string out through the text cache, then writes its glyphs like any other sprites
+static void internal_emit_text(f32 x, f32 y, f32 font_size, const char* text, const bitmap_font* font, color4 color, f32 z) {
+    const text_run* run = text_cache_get(&renderer.text_runs, font, text);
+    if (!run) return;
+
+    sprite_instance sprites[QUAD_KERNEL_CHUNK];
+
+    for (u32 first = 0; first < run->glyph_count; first += QUAD_KERNEL_CHUNK) {
+        u32 count = run->glyph_count - first < QUAD_KERNEL_CHUNK ? run->glyph_count - first : QUAD_KERNEL_CHUNK;
+
+        for (u32 i = 0; i < count; i++) {
+            const text_glyph* glyph = &run->glyphs[first + i];
+            sprite_instance* sprite = &sprites[i];
+            sprite->x = x + (glyph->x + 0.5f) * font_size;
+            sprite->y = y + font_size * 0.5f;
+            sprite->width = font_size;
+            sprite->height = font_size;
+            sprite->rotation = 0.0f;
+            sprite->z = z;
+            sprite->texture = font->texture_id;
+            sprite->rect = glyph->rect;
+            sprite->color = color;
         }
+
+        internal_submit_sprites(sprites, count);
     }
+}
 
-    f32 x_offset = -renderer.screen_width / 2.0f;
-    f32 y_offset = -renderer.screen_height / 2.0f;
+// Records the quad in deferred mode, a queue that can't grow falls back to drawing right away
+static void internal_queue_quad(f32 x, f32 y, f32 width, f32 height, f32 rotation_rad, const uv_rect* rect, color4 color, i32 texture_slot, f32 z) {
+    if (renderer.deferred) {
+        render_command* command = render_queue_push(&renderer.queue, RENDER_COMMAND_QUAD, z, texture_array_sort_key(texture_slot));
+        if (command) {
+            command->color = color;
+            command->quad.x = x;
+            command->quad.y = y;
+            command->quad.width = width;
+            command->quad.height = height;
+            command->quad.rotation = rotation_rad;
+            command->quad.texture = texture_slot;
+            command->quad.rect = *rect;
+            return;
+        }
+    }
 
-    f32 hw = width * 0.5f;
-    f32 hh = height * 0.5f;
+    internal_submit_quad(x, y, width, height, rotation_rad, rect, color, texture_slot, z);
+}
 
-    f32 positions[4][2] = {
-        { x - hw + x_offset, y - hh + y_offset },
-        { x + hw + x_offset, y - hh + y_offset },
-        { x + hw + x_offset, y + hh + y_offset },
-        { x - hw + x_offset, y + hh + y_offset }
-    };
+static void internal_draw_quad(f32 x, f32 y, f32 width, f32 height, f32 rotation_rad, const uv_rect* rect, color4 color, i32 texture_slot, f32 z) {
+    if (renderer.capturing) {
+        frame_capture_quad(x, y, width, height, rotation_rad, rect, color, texture_slot, z);
+    }
 
-    f32 tex_coords[4][2] = {
-        { rect->u0, rect->v0 },
-        { rect->u1, rect->v0 },
-        { rect->u1, rect->v1 },
-        { rect->u0, rect->v1 }
-    };
+    internal_queue_quad(x, y, width, height, rotation_rad, rect, color, texture_slot, z);
+}
+
+// Window pixels to the target pixels they are upscaled from, rounded outwards
+static void internal_scissor_to_target(i32* x, i32* y, i32* width, i32* height) {
+    f32 scale = (f32)renderer.pixel_scale;
+    i32 x0 = (i32)floorf(((f32)*x + 0.5f + renderer.camera_offset[0]) / scale);
+    i32 y0 = (i32)floorf(((f32)*y + 0.5f + renderer.camera_offset[1]) / scale);
+    i32 x1 = (i32)floorf(((f32)(*x + *width) - 0.5f + renderer.camera_offset[0]) / scale);
+    i32 y1 = (i32)floorf(((f32)(*y + *height) - 0.5f + renderer.camera_offset[1]) / scale);
+
+    *x = x0;
+    *y = y0;
+    *width = *width > 0 ? x1 - x0 + 1 : 0;
+    *height = *height > 0 ? y1 - y0 + 1 : 0;
+}
 
-    for (int i = 0; i < 4; i++) {
-        renderer.vertex_buffer_ptr->position[0] = positions[i][0];
-        renderer.vertex_buffer_ptr->position[1] = positions[i][1];
-        renderer.vertex_buffer_ptr->position[2] = z;
-        memcpy(renderer.vertex_buffer_ptr->color, &color.r, 4 * sizeof(f32));
-        memcpy(renderer.vertex_buffer_ptr->tex_coord, tex_coords[i], 2 * sizeof(f32));
-        renderer.vertex_buffer_ptr->tex_index = tex_index;
-        renderer.vertex_buffer_ptr++;
+static void internal_apply_scissor(u8 enabled, i32 x, i32 y, i32 width, i32 height) {
+    if (renderer.indices_count > 0) {
+        internal_next_batch(RENDERER2D_FLUSH_STATE_CHANGE); // Quads before the change are drawn with the old state
     }
 
-    renderer.indices_count += 6;
+    if (renderer.pixel_scale > 1) {
+        internal_scissor_to_target(&x, &y, &width, &height);
+    }
+
+    if (renderer.software) {
+        software_rasterizer_set_scissor(enabled, x, y, width, height);
+    }
+    else if (enabled) {
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(x, y, width, height);
+    }
+    else {
+        glDisable(GL_SCISSOR_TEST);
+    }
 }
 
-void renderer2D_draw_rotated_quad_atlas(f32 x, f32 y, f32 width, f32 height, i32 texture_slot, const uv_rect* rect, color4 color, f32 rotation_rad, f32 z) {
-    if (renderer.indices_count >= MAX_INDICES) {
-        renderer2D_flush();
-        renderer2D_begin_batch();
+// -- STATIC BATCHES --
+
+struct renderer2D_static_batch {
+    GLuint vao, vbo;            // Own vertices, indices come from the shared index buffer
+    u32 count;
+    u32 capacity;
+    sprite_instance* sprites;   // What each quad was built from, setting an equal sprite is skipped
+    vertex* vertices;           // Copy of the buffer, written quads are uploaded from it
+    u32 dirty_begin, dirty_end; // Quads written since the last upload
+    GLuint texture_slots[MAX_TEXTURE_SLOTS];
+    u32 slot_pages[MAX_TEXTURE_SLOTS];
+    u32 texture_slot_count;
+};
+
+static i32 internal_static_batch_slot(renderer2D_static_batch* batch, u32 page) {
+    for (u32 i = 0; i < batch->texture_slot_count; i++) {
+        if (batch->slot_pages[i] == page) return (i32)i;
     }
 
+    if (batch->texture_slot_count >= MAX_TEXTURE_SLOTS) return -1;
+
+    batch->texture_slots[batch->texture_slot_count] = texture_array_page_texture(page);
+    batch->slot_pages[batch->texture_slot_count] = page;
+    return (i32)batch->texture_slot_count++;
+}
+
+// Expands quad index from its sprite into the vertex copy, false if its page needs a slot and none is left
+static u8 internal_static_batch_write(renderer2D_static_batch* batch, u32 index) {
+    const sprite_instance* sprite = &batch->sprites[index];
+
+    uv_rect rect = sprite->rect;
+    i32 tex_layer = 0;
     i32 tex_index = -1;
 
-    if (texture_slot != -1) {
-        for (u32 i = 1; i < renderer.texture_slot_index; i++) {
-            if (renderer.texture_slots[i] == (GLuint)texture_slot) {
-                tex_index = (i32)i;
-                break;
-            }
-        }
+    const texture_array_entry* entry = texture_array_get(sprite->texture);
+    if (entry) {
+        tex_index = internal_static_batch_slot(batch, entry->page);
+        if (tex_index < 0) return false;
 
-        if (tex_index == -1) {
-            if (renderer.texture_slot_index >= MAX_TEXTURE_SLOTS) {
-                renderer2D_flush();
-                renderer2D_begin_batch();
-            }
+        internal_map_texture_rect(entry, &sprite->rect, &rect);
+        tex_layer = entry->layer;
+    }
 
-            tex_index = (i32)renderer.texture_slot_index;
-            renderer.texture_slots[renderer.texture_slot_index++] = (GLuint)texture_slot;
-        }
+    f32 positions[4][2];
+    quad_kernel_corners(&sprite->x, &sprite->y, &sprite->width, &sprite->height, &sprite->rotation, 1,
+                        -renderer.screen_width / 2.0f, -renderer.screen_height / 2.0f, &positions);
+    internal_write_quad(batch->vertices + (size_t)index * 4, positions, sprite->z, sprite->color, &rect, tex_index, tex_layer);
+
+    if (batch->dirty_begin >= batch->dirty_end) {
+        batch->dirty_begin = index;
+        batch->dirty_end = index + 1;
+    }
+    else {
+        if (index < batch->dirty_begin) batch->dirty_begin = index;
+        if (index + 1 > batch->dirty_end) batch->dirty_end = index + 1;
     }
 
-    f32 hw = width / 2.0f;
-    f32 hh = height / 2.0f;
+    return true;
+}
 
-    f32 x_offset = -renderer.screen_width / 2.0f;
-    f32 y_offset = -renderer.screen_height / 2.0f;
+// Assigns the slots again from the first count sprites, pages only the replaced sprites used are dropped
+static u8 internal_static_batch_rebuild(renderer2D_static_batch* batch, u32 count) {
+    batch->texture_slot_count = 0;
 
-    // Quad vertices centered at origin
-    f32 local_positions[4][2] = {
-        { -hw, -hh },
-        {  hw, -hh },
-        {  hw,  hh },
-        { -hw,  hh }
-    };
+    for (u32 i = 0; i < count; i++) {
+        if (!internal_static_batch_write(batch, i)) return false;
+    }
 
-    // Rotation matrix
-    f32 cos_theta = cosf(rotation_rad);
-    f32 sin_theta = sinf(rotation_rad);
+    return true;
+}
 
-    f32 tex_coords[4][2] = {
-        { rect->u0, rect->v0 },
-        { rect->u1, rect->v0 },
-        { rect->u1, rect->v1 },
-        { rect->u0, rect->v1 }
-    };
+// Uploads the quads written since the last draw and draws the whole batch with one call
+static void internal_draw_static_batch(renderer2D_static_batch* batch) {
+    if (batch->count == 0) return;
 
-    for (int i = 0; i < 4; i++) {
-        f32 rx = local_positions[i][0] * cos_theta - local_positions[i][1] * sin_theta;
-        f32 ry = local_positions[i][0] * sin_theta + local_positions[i][1] * cos_theta;
+    if (renderer.indices_count > 0) {
+        internal_next_batch(RENDERER2D_FLUSH_STATIC_BATCH); // Quads submitted before the batch stay underneath it
+    }
 
-        renderer.vertex_buffer_ptr->position[0] = x + rx + x_offset;
-        renderer.vertex_buffer_ptr->position[1] = y + ry + y_offset;
-        renderer.vertex_buffer_ptr->position[2] = z;
+    renderer.frame_stats.draw_calls++;
+    renderer.frame_stats.static_quads += batch->count;
 
-        memcpy(renderer.vertex_buffer_ptr->color, &color.r, 4 * sizeof(f32));
-        memcpy(renderer.vertex_buffer_ptr->tex_coord, tex_coords[i], 2 * sizeof(f32));
-        renderer.vertex_buffer_ptr->tex_index = tex_index;
-        renderer.vertex_buffer_ptr++;
+    if (renderer.software) {
+        // The vertex copy is all there is, nothing to upload
+        internal_rasterize_quads(batch->vertices, batch->count, batch->slot_pages);
+        batch->dirty_begin = 0;
+        batch->dirty_end = 0;
+        return;
     }
 
-    renderer.indices_count += 6;
-}
+    if (batch->dirty_begin < batch->dirty_end) {
+        glBindBuffer(GL_ARRAY_BUFFER, batch->vbo);
+        glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)((size_t)batch->dirty_begin * 4 * sizeof(vertex)),
+                        (GLsizeiptr)((size_t)(batch->dirty_end - batch->dirty_begin) * 4 * sizeof(vertex)),
+                        batch->vertices + (size_t)batch->dirty_begin * 4);
+        batch->dirty_begin = 0;
+        batch->dirty_end = 0;
+    }
 
-void renderer2D_draw_rotated_quad(f32 x, f32 y, f32 width, f32 height, i32 texture_slot, color4 color, f32 rotation_rad, f32 z) {
-    if (renderer.indices_count >= MAX_INDICES) {
-        renderer2D_flush();
-        renderer2D_begin_batch();
+    glUseProgram(renderer.shader_program);
+    glBindVertexArray(batch->vao);
+
+    for (u32 i = 0; i < batch->texture_slot_count; i++) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, batch->texture_slots[i]);
     }
 
-    i32 tex_index = -1;
+    glDrawElements(GL_TRIANGLES, (GLsizei)(batch->count * 6), GL_UNSIGNED_INT, NULL);
+}
 
-    if (texture_slot != -1) {
-        for (u32 i = 1; i < renderer.texture_slot_index; i++) {
-            if (renderer.texture_slots[i] == (GLuint)texture_slot) {
-                tex_index = (i32)i;
-                break;
-            }
-        }
+// -- STATIC BATCHES --
 
-        if (tex_index == -1) {
-            if (renderer.texture_slot_index >= MAX_TEXTURE_SLOTS) {
-                renderer2D_flush();
-                renderer2D_begin_batch();
-            }
+// Sorts the recorded commands and expands them into the batch in one pass
+static void internal_process_queue() {
+    render_queue* queue = &renderer.queue;
+    if (queue->count == 0) return;
+
+    render_queue_sort(queue);
 
-            tex_index = (i32)renderer.texture_slot_index;
-            renderer.texture_slots[renderer.texture_slot_index++] = (GLuint)texture_slot;
+    for (u32 i = 0; i < queue->count;) {
+        const render_command* command = render_queue_get(queue, i);
+
+        if (command->type == RENDER_COMMAND_QUAD) {
+            i = internal_expand_quad_run(queue, i);
+            continue;
+        }
+
+        switch (command->type) {
+        case RENDER_COMMAND_TEXT:
+            internal_emit_text(command->text.x, command->text.y, command->text.font_size, queue->text + command->text.text_offset,
+                               command->text.font, command->color, command->z);
+            break;
+        case RENDER_COMMAND_SCISSOR:
+            internal_apply_scissor(command->scissor.enabled, command->scissor.x, command->scissor.y, command->scissor.width, command->scissor.height);
+            break;
+        case RENDER_COMMAND_STATIC_BATCH:
+            internal_draw_static_batch(command->static_batch.batch);
+            break;
         }
+
+        i++;
     }
 
-    f32 hw = width / 2.0f;
-    f32 hh = height / 2.0f;
+    render_queue_reset(queue);
+}
 
-    f32 x_offset = -renderer.screen_width / 2.0f;
-    f32 y_offset = -renderer.screen_height / 2.0f;
+static void internal_set_scissor(u8 enabled, i32 x, i32 y, i32 width, i32 height) {
+    if (renderer.capturing) {
+        frame_capture_scissor(enabled, x, y, width, height);
+    }
 
-    // Quad vertices centered at origin
-    f32 local_positions[4][2] = {
-        { -hw, -hh },
-        {  hw, -hh },
-        {  hw,  hh },
-        { -hw,  hh }
-    };
+    if (renderer.deferred) {
+        // Commands recorded so far stay on their side of the change
+        if (!render_queue_next_epoch(&renderer.queue)) {
+            internal_process_queue();
+        }
 
-    // Rotation matrix
-    f32 cos_theta = cosf(rotation_rad);
-    f32 sin_theta = sinf(rotation_rad);
+        render_command* command = render_queue_push(&renderer.queue, RENDER_COMMAND_SCISSOR, 0.0f, 0);
+        if (command) {
+            command->scissor.enabled = enabled;
+            command->scissor.x = x;
+            command->scissor.y = y;
+            command->scissor.width = width;
+            command->scissor.height = height;
+            return;
+        }
 
-    f32 tex_coords[4][2] = {
-        { 0.0f, 0.0f },
-        { 1.0f, 0.0f },
-        { 1.0f, 1.0f },
-        { 0.0f, 1.0f }
-    };
+        internal_process_queue();
+    }
+
+    internal_apply_scissor(enabled, x, y, width, height);
+}
+
+void renderer2D_draw_quad(f32 x, f32 y, f32 width, f32 height, i32 texture_slot, color4 color, f32 z) {
+    const uv_rect full = { 0.0f, 0.0f, 1.0f, 1.0f };
+    internal_draw_quad(x, y, width, height, 0.0f, &full, color, texture_slot, z);
+}
+
+void renderer2D_draw_quad_atlas(f32 x, f32 y, f32 width, f32 height, i32 texture_slot, const uv_rect* rect, color4 color, f32 z) {
+    internal_draw_quad(x, y, width, height, 0.0f, rect, color, texture_slot, z);
+}
 
-    for (int i = 0; i < 4; i++) {
-        f32 rx = local_positions[i][0] * cos_theta - local_positions[i][1] * sin_theta;
-        f32 ry = local_positions[i][0] * sin_theta + local_positions[i][1] * cos_theta;
+void renderer2D_draw_rotated_quad_atlas(f32 x, f32 y, f32 width, f32 height, i32 texture_slot, const uv_rect* rect, color4 color, f32 rotation_rad, f32 z) {
+    internal_draw_quad(x, y, width, height, rotation_rad, rect, color, texture_slot, z);
+}
 
-        renderer.vertex_buffer_ptr->position[0] = x + rx + x_offset;
-        renderer.vertex_buffer_ptr->position[1] = y + ry + y_offset;
-        renderer.vertex_buffer_ptr->position[2] = z;
+void renderer2D_draw_rotated_quad(f32 x, f32 y, f32 width, f32 height, i32 texture_slot, color4 color, f32 rotation_rad, f32 z) {
+    const uv_rect full = { 0.0f, 0.0f, 1.0f, 1.0f };
+    internal_draw_quad(x, y, width, height, rotation_rad, &full, color, texture_slot, z);
+}
 
-        memcpy(renderer.vertex_buffer_ptr->color, &color.r, 4 * sizeof(f32));
-        memcpy(renderer.vertex_buffer_ptr->tex_coord, tex_coords[i], 2 * sizeof(f32));
-        renderer.vertex_buffer_ptr->tex_index = tex_index;
-        renderer.vertex_buffer_ptr++;
+void renderer2D_draw_sprites(const sprite_instance* sprites, u32 count) {
+    if (renderer.capturing) {
+        frame_capture_sprites(sprites, count);
     }
 
-    renderer.indices_count += 6;
+    if (renderer.deferred) {
+        for (u32 i = 0; i < count; i++) {
+            const sprite_instance* sprite = &sprites[i];
+            internal_queue_quad(sprite->x, sprite->y, sprite->width, sprite->height, sprite->rotation, &sprite->rect, sprite->color, sprite->texture, sprite->z);
+        }
+        return;
+    }
+
+    internal_submit_sprites(sprites, count);
 }
 
+
 void renderer2D_draw_animated_sprite(f32 x, f32 y, f32 width, f32 height, const animated_sprite* sprite, color4 color, f32 rotation_rad, f32 z) {
     if (!sprite->anim_state.animation) return;
 
@@ -411,106 +1218,340 @@ void renderer2D_draw_animated_sprite(f32 x, f32 y, f32 width, f32 height, const
 }
 
 void renderer2D_draw_bitmap_text(f32 x, f32 y, f32 font_size, const char* text, const bitmap_font* font, color4 color, f32 z) {
-    if (!text || !font || font->glyph_width <= 0 || font->glyph_height <= 0) return;
+    if (!text || !font) return;
 
-    f32 cursor_x = x;
-
-    for (size_t i = 0; text[i] != '\0'; ++i) {
-        char c = text[i];
+    if (renderer.capturing) {
+        frame_capture_text(x, y, font_size, text, font, color, z);
+    }
 
-        if (c == ' ') {
-            cursor_x += font_size * font->space_width;
-            continue;
+    if (renderer.deferred) {
+        // One command for the whole run, it is laid out when the queue is flushed
+        u32 text_offset = 0;
+        render_command* command = render_queue_push_text(&renderer.queue, text, &text_offset)
+            ? render_queue_push(&renderer.queue, RENDER_COMMAND_TEXT, z, texture_array_sort_key(font->texture_id)) : NULL;
+        if (command) {
+            command->color = color;
+            command->text.x = x;
+            command->text.y = y;
+            command->text.font_size = font_size;
+            command->text.font = font;
+            command->text.text_offset = text_offset;
+            return;
         }
+    }
 
-        int index = -1;
+    internal_emit_text(x, y, font_size, text, font, color, z);
+}
 
-        if (c >= 'A' && c <= 'Z') {
-            index = c - 'A';
-        }
-        else if (c >= 'a' && c <= 'z') {
-            index = 26 + (c - 'a');
+renderer2D_static_batch* renderer2D_static_batch_create(u32 capacity) {
+    if (capacity == 0 || capacity > MAX_QUADS) return NULL; // Drawn with the shared index buffer
+
+    renderer2D_static_batch* batch = (renderer2D_static_batch*)calloc(1, sizeof(renderer2D_static_batch));
+    if (!batch) return NULL;
+
+    batch->capacity = capacity;
+    batch->sprites = (sprite_instance*)malloc(sizeof(sprite_instance) * capacity);
+    batch->vertices = (vertex*)malloc(sizeof(vertex) * 4 * capacity);
+    if (!batch->sprites || !batch->vertices) {
+        renderer2D_static_batch_destroy(batch);
+        return NULL;
+    }
+
+    if (renderer.software) return batch;
+
+    glGenVertexArrays(1, &batch->vao);
+    glBindVertexArray(batch->vao);
+
+    glGenBuffers(1, &batch->vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, batch->vbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(sizeof(vertex) * 4 * capacity), NULL, GL_DYNAMIC_DRAW);
+    internal_set_vertex_layout();
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderer.ibo);
+    glBindVertexArray(renderer.vao);
+
+    return batch;
+}
+
+void renderer2D_static_batch_destroy(renderer2D_static_batch* batch) {
+    if (!batch) return;
+
+    frame_capture_static_forget(batch);
+
+    if (batch->vbo) glDeleteBuffers(1, &batch->vbo);
+    if (batch->vao) glDeleteVertexArrays(1, &batch->vao);
+    free(batch->sprites);
+    free(batch->vertices);
+    free(batch);
+}
+
+u8 renderer2D_static_batch_set(renderer2D_static_batch* batch, u32 index, const sprite_instance* sprite) {
+    frame_capture_static_set(batch, batch->capacity, batch->sprites, batch->count, index, sprite); // Before the batch changes
+    if (index > batch->count || index >= batch->capacity) return false;
+
+    // The common case for a retained batch, nothing to write
+    if (index < batch->count && memcmp(&batch->sprites[index], sprite, sizeof(sprite_instance)) == 0) return true;
+
+    sprite_instance previous = batch->sprites[index];
+    batch->sprites[index] = *sprite;
+
+    u32 count = index == batch->count ? index + 1 : batch->count;
+    if (internal_static_batch_write(batch, index) || internal_static_batch_rebuild(batch, count)) {
+        batch->count = count;
+        return true;
+    }
+
+    // Too many pages even after dropping unused ones, keep the batch as it was
+    batch->sprites[index] = previous;
+    internal_static_batch_rebuild(batch, batch->count);
+    return false;
+}
+
+void renderer2D_static_batch_truncate(renderer2D_static_batch* batch, u32 count) {
+    frame_capture_static_truncate(batch, batch->capacity, batch->sprites, batch->count, count);
+
+    if (count < batch->count) {
+        batch->count = count;
+    }
+}
+
+u32 renderer2D_static_batch_count(const renderer2D_static_batch* batch) {
+    return batch->count;
+}
+
+void renderer2D_draw_static_batch(renderer2D_static_batch* batch) {
+    if (renderer.capturing) {
+        frame_capture_static_draw(batch, batch->capacity, batch->sprites, batch->count);
+    }
+
+    if (batch->count == 0) return;
+
+    if (renderer.deferred) {
+        // Sorted by its nearest-to-the-back quad, the quads inside keep the batch's order
+        f32 z = batch->sprites[0].z;
+        for (u32 i = 1; i < batch->count; i++) {
+            if (batch->sprites[i].z < z) z = batch->sprites[i].z;
         }
-        else {
-            // Unsupported char  skip or draw default glyph
-            cursor_x += font_size * font->space_width;
-            continue;
+
+        render_command* command = render_queue_push(&renderer.queue, RENDER_COMMAND_STATIC_BATCH, z, 0);
+        if (command) {
+            command->static_batch.batch = batch;
+            return;
         }
 
-        int col = index % font->atlas_columns;
-        int row = index / font->atlas_columns;
+        internal_process_queue();
+    }
 
-        f32 glyph_height_uv = 1.0f / (f32)(font->atlas_rows);
-        f32 glyph_width_uv = 1.0f / (f32)(font->atlas_columns);
+    internal_draw_static_batch(batch);
+}
 
-        f32 u0 = col * glyph_width_uv;
-        f32 u1 = u0 + glyph_width_uv;
+void renderer2D_set_scissor(i32 x, i32 y, i32 width, i32 height) {
+    internal_set_scissor(true, x, y, width, height);
+}
 
-        f32 v1 = 1.0f - row * glyph_height_uv;
-        f32 v0 = v1 - glyph_height_uv;
+void renderer2D_disable_scissor() {
+    internal_set_scissor(false, 0, 0, 0, 0);
+}
 
-        uv_rect uv = { u0, v0, u1, v1 };
+void renderer2D_set_deferred(u8 enabled) {
+    if (renderer.deferred == enabled) return;
 
-        renderer2D_draw_quad_atlas(
-            cursor_x + font_size * 0.5f,
-            y + font_size * 0.5f,
-            font_size,
-            font_size,
-            font->texture_id,
-            &uv,
-            color,
-            z
-        );
+    if (renderer.capturing) {
+        frame_capture_deferred(enabled);
+    }
 
-        cursor_x += font_size * font->kerning;
+    internal_process_queue(); // Recorded commands still go out sorted
+    renderer.deferred = enabled;
+}
+
+void renderer2D_set_instancing(u8 enabled) {
+    if (renderer.instanced == enabled || renderer.software) return; // Instances are expanded on the GPU
+
+    if (renderer.capturing) {
+        frame_capture_instancing(enabled);
     }
+
+    internal_process_queue(); // Queued quads were recorded for the current mode
+
+    // Quads already in the batch are drawn the way they were written
+    if (renderer.indices_count > 0) {
+        internal_draw_batch(RENDERER2D_FLUSH_MODE_SWITCH);
+        renderer.instanced = enabled;
+        renderer2D_begin_batch();
+        return;
+    }
+
+    renderer.instanced = enabled;
 }
 
 void renderer2D_begin_batch() {
-    renderer.vertex_buffer_ptr = renderer.vertex_buffer_base;
+    internal_map_region();
     renderer.indices_count = 0;
-    renderer.texture_slot_index = 1; // Slot 0 is white texture
+    renderer.texture_slot_index = 0;
+    renderer.batch_id++; // Forgets which pages the previous batch had bound
 }
 
 void renderer2D_end_batch() {
-    size_t size = (uint8_t*)renderer.vertex_buffer_ptr - (uint8_t*)renderer.vertex_buffer_base;
-    glBindBuffer(GL_ARRAY_BUFFER, renderer.vbo);
-    glBufferData(GL_ARRAY_BUFFER, MAX_VERTICES * sizeof(vertex), NULL, GL_STATIC_DRAW);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, size, renderer.vertex_buffer_base);
+    // Vertices were written straight into the buffer, only a temporary mapping has to be released
+    if (renderer.region_mapped) {
+        glBindBuffer(GL_ARRAY_BUFFER, renderer.vbo);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        renderer.region_mapped = false;
+    }
 }
 
 void renderer2D_flush() {
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    if (renderer.indices_count == 0) {
-        return; // Return from function because there is nothing to draw
+    if (renderer.capturing) {
+        frame_capture_flush();
     }
 
-    glUseProgram(renderer.shader_program); // Use the shaders from earlier in drawing
+    internal_process_queue();
+    internal_draw_batch(RENDERER2D_FLUSH_EXPLICIT);
+    renderer2D_begin_batch();
+}
+
+void renderer2D_begin_frame() {
+    memset(&renderer.frame_stats, 0, sizeof(renderer.frame_stats));
+    renderer.in_frame = true;
+    renderer.capturing = frame_capture_begin_frame(renderer.deferred, renderer.instanced, renderer.camera_x, renderer.camera_y);
+    internal_update_view();
+
+    // The only clear of the frame, every batch drawn until renderer2D_end_frame adds to it
+    if (renderer.software) {
+        const u8 clear_color[4] = { 51, 51, 51, 255 }; // glClearColor of the OpenGL backend
+        software_rasterizer_set_scissor(false, 0, 0, 0, 0);
+        software_rasterizer_clear(clear_color);
+    }
+    else {
+        if (renderer.pixel_scale > 1) {
+            glBindFramebuffer(GL_FRAMEBUFFER, renderer.target_fbo);
+            glViewport(0, 0, renderer.target_width, renderer.target_height);
+        }
 
-    glBindVertexArray(renderer.vao); // Use the quad vertices in the buffer
+        glDisable(GL_SCISSOR_TEST);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
 
-    // Bind white texture to slot 0 always
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, renderer.white_texture);
+    renderer2D_begin_batch();
+}
 
-    for (uint32_t i = 1; i < renderer.texture_slot_index; i++) {
-        glActiveTexture(GL_TEXTURE0 + i);
-        glBindTexture(GL_TEXTURE_2D, renderer.texture_slots[i]);
+void renderer2D_end_frame() {
+    if (!renderer.in_frame) return;
+
+    internal_process_queue();
+    internal_draw_batch(RENDERER2D_FLUSH_END_FRAME);
+    renderer.in_frame = false;
+
+    if (renderer.capturing) {
+        frame_capture_end_frame();
+        renderer.capturing = false;
+    }
+    renderer.last_frame_stats = renderer.frame_stats;
+
+    // The only present of the frame
+    if (renderer.software) {
+        software_rasterizer_flush();
+        if (renderer.pixel_scale > 1) internal_upscale_software();
+        platform_present_pixels(renderer2D_get_software_pixels(), renderer.screen_width, renderer.screen_height);
+    }
+    else {
+        if (renderer.pixel_scale > 1) internal_upscale_target();
+        platform_swap_buffers();
+    }
+}
+
+void renderer2D_get_frame_stats(renderer2D_frame_stats* out_stats) {
+    *out_stats = renderer.last_frame_stats;
+}
+
+const u8* renderer2D_get_software_pixels() {
+    if (!renderer.software) return NULL;
+    return renderer.pixel_scale > 1 ? renderer.software_upscaled : software_rasterizer_pixels();
+}
+
+u8 renderer2D_set_pixel_scale(i32 scale) {
+    if (scale < 1 || renderer.in_frame) return false;
+    if (scale == renderer.pixel_scale) return true;
+
+    // A logical pixel more than the window needs, the sub-pixel camera offset shifts the view into it
+    i32 target_width = scale > 1 ? (renderer.screen_width + scale - 1) / scale + 1 : renderer.screen_width;
+    i32 target_height = scale > 1 ? (renderer.screen_height + scale - 1) / scale + 1 : renderer.screen_height;
+
+    u8 created = renderer.software ? internal_create_software_target(scale, target_width, target_height)
+                                   : internal_create_pixel_target(scale, target_width, target_height);
+    if (!created) {
+        scale = 1; // Back to drawing straight to the window
+        target_width = renderer.screen_width;
+        target_height = renderer.screen_height;
+
+        if (renderer.software) internal_create_software_target(scale, target_width, target_height);
+        else internal_create_pixel_target(scale, target_width, target_height);
     }
 
-    glDrawElements(GL_TRIANGLES, renderer.indices_count, GL_UNSIGNED_INT, NULL); // Draw the quads using the shaders
-    platform_swap_buffers(); // Swap buffers to display new stuff
+    renderer.pixel_scale = scale;
+    renderer.target_width = target_width;
+    renderer.target_height = target_height;
+    return created;
+}
+
+void renderer2D_set_camera(f32 x, f32 y) {
+    renderer.camera_x = x;
+    renderer.camera_y = y;
+}
+
+u8 renderer2D_capture_frames(const char* path, u32 frame_count) {
+    return frame_capture_open(path, renderer.screen_width, renderer.screen_height, frame_count);
 }
 
 void renderer2D_shutdown() {
+    frame_capture_close(); // A capture still running keeps the frames it has
+    texture_array_shutdown();
+    render_queue_free(&renderer.queue);
+    text_cache_free(&renderer.text_runs);
+    free(renderer.quad_jobs);
+    renderer.quad_jobs = NULL;
+
+    if (renderer.software) {
+        software_rasterizer_shutdown();
+        free(renderer.software_vertices);
+        free(renderer.software_upscaled);
+        free(renderer.software_columns);
+        renderer.software_vertices = NULL;
+        renderer.software_upscaled = NULL;
+        renderer.software_columns = NULL;
+        renderer.vertex_buffer_base = NULL;
+        return;
+    }
+
+    renderer2D_end_batch();
+
+    for (u32 i = 0; i < RENDERER_BUFFER_REGIONS; i++) {
+        if (renderer.region_fences[i]) {
+            glDeleteSync(renderer.region_fences[i]);
+            renderer.region_fences[i] = NULL;
+        }
+    }
+
+    if (renderer.persistent_map) {
+        glBindBuffer(GL_ARRAY_BUFFER, renderer.vbo);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        renderer.persistent_map = NULL;
+    }
+
     // Free up all allocated resources
     glDeleteBuffers(1, &renderer.vbo);
     glDeleteBuffers(1, &renderer.ibo);
+    glDeleteBuffers(1, &renderer.corner_vbo);
     glDeleteVertexArrays(1, &renderer.vao);
-    glDeleteTextures(1, &renderer.white_texture);
+    glDeleteVertexArrays(1, &renderer.instanced_vao);
     glDeleteProgram(renderer.shader_program);
-
-    if (renderer.vertex_buffer_base) {
-        free(renderer.vertex_buffer_base);
+    glDeleteProgram(renderer.instanced_shader_program);
+
+    internal_destroy_pixel_target();
+    if (renderer.upscale_program) {
+        glDeleteProgram(renderer.upscale_program);
+        glDeleteVertexArrays(1, &renderer.upscale_vao);
+        renderer.upscale_program = 0;
+        renderer.upscale_vao = 0;
     }
-}
\ No newline at end of file
+}
@@ -5,14 +5,86 @@
 #include <renderer/bitmap_font.h>
 #include <animation/sprite_animation.h>
 
-u8 renderer2D_init(i32 width, i32 height);
+#define RENDERER2D_MAX_BATCH_QUADS 1000 // Quads per draw call
+
+// Why a batch was drawn, everything but END_FRAME splits the frame into more draw calls
+typedef enum {
+    RENDERER2D_FLUSH_END_FRAME,
+    RENDERER2D_FLUSH_EXPLICIT,       // renderer2D_flush
+    RENDERER2D_FLUSH_QUAD_LIMIT,     // MAX_QUADS reached
+    RENDERER2D_FLUSH_TEXTURE_SLOTS,  // Every texture slot taken by another page
+    RENDERER2D_FLUSH_MODE_SWITCH,    // Instancing turned on or off
+    RENDERER2D_FLUSH_STATE_CHANGE,   // Scissor set or disabled
+    RENDERER2D_FLUSH_STATIC_BATCH,   // Static batch drawn in between
+    RENDERER2D_FLUSH_REASON_COUNT
+} renderer2D_flush_reason;
+
+typedef struct {
+    u32 draw_calls;
+    u32 quads;
+    u32 static_quads;  // Drawn from static batches, nothing was written for them this frame
+    u32 flushes[RENDERER2D_FLUSH_REASON_COUNT]; // Draw calls by reason
+} renderer2D_frame_stats;
+
+// One quad of renderer2D_draw_sprites
+typedef struct {
+    f32 x, y, width, height;
+    f32 rotation;  // Radians
+    f32 z;
+    i32 texture;   // -1 for none
+    uv_rect rect;
+    color4 color;
+} sprite_instance;
+
+// Retained quads for geometry that rarely changes, like the HUD or background layers. Quads are expanded
+// once into a buffer owned by the batch and the whole batch is drawn with one call. Setting a quad to the
+// sprite it already has costs a compare, changed quads are uploaded as one range before the next draw.
+// A batch uses at most 8 texture pages and its textures must stay alive while it does.
+typedef struct renderer2D_static_batch renderer2D_static_batch;
+
+// The software backend draws the same frames on the CPU, for machines without a usable GPU and as a
+// deterministic reference to diff images against. Instancing is ignored there.
+typedef enum {
+    RENDERER2D_BACKEND_OPENGL,
+    RENDERER2D_BACKEND_SOFTWARE
+} renderer2D_backend;
+
+u8 renderer2D_init(i32 width, i32 height); // OpenGL backend
+u8 renderer2D_init_backend(i32 width, i32 height, renderer2D_backend backend);
+const u8* renderer2D_get_software_pixels(); // Last frame as RGBA8 rows from the bottom, NULL with the OpenGL backend
+void renderer2D_set_instancing(u8 enabled); // One record per quad expanded on the GPU instead of four vertices
+void renderer2D_set_deferred(u8 enabled);   // Record draw calls and sort them by depth and texture before expanding them
+
+// Pixel art mode: the scene is drawn at window size / scale, then upscaled to the window with one nearest neighbour
+// pass, so each art pixel is shaded once instead of scale * scale times. Draw calls keep using window pixels and
+// scissor rects grow to whole logical pixels. 1 draws straight to the window again. False inside a frame or if the
+// target can't be created, the renderer is then back at 1.
+u8 renderer2D_set_pixel_scale(i32 scale);
+void renderer2D_set_camera(f32 x, f32 y); // Window pixel at the bottom left from the next frame on, sub-pixel moves stay smooth in pixel art mode
+
+// A frame is cleared once in begin_frame and presented once in end_frame, any number of batches can
+// be drawn in between. Draw calls are only valid inside a frame.
+void renderer2D_begin_frame();
+void renderer2D_end_frame();
+void renderer2D_get_frame_stats(renderer2D_frame_stats* out_stats); // Stats of the last frame that ended
+u8 renderer2D_capture_frames(const char* path, u32 frame_count); // Writes the calls of the next frames to a capture, see frame_capture.h
+
 void renderer2D_begin_batch();
 void renderer2D_draw_quad(f32 x, f32 y, f32 width, f32 height, i32 texture_slot, color4 color, f32 z);
 void renderer2D_draw_quad_atlas(f32 x, f32 y, f32 width, f32 height, i32 texture_slot, const uv_rect* rect, color4 color, f32 z);
 void renderer2D_draw_rotated_quad_atlas(f32 x, f32 y, f32 width, f32 height, i32 texture_slot, const uv_rect* rect, color4 color, f32 rotation_rad, f32 z);
 void renderer2D_draw_rotated_quad(f32 x, f32 y, f32 width, f32 height, i32 texture_slot, color4 color, f32 rotation_rad, f32 z);
+void renderer2D_draw_sprites(const sprite_instance* sprites, u32 count); // Expands several quads per iteration, cheaper than a call per quad
 void renderer2D_draw_animated_sprite(f32 x, f32 y, f32 width, f32 height, const animated_sprite* sprite, color4 color, f32 rotation_rad, f32 z);
 void renderer2D_draw_bitmap_text(f32 x, f32 y, f32 font_size, const char* text, const bitmap_font* font, color4 color, f32 z);
+renderer2D_static_batch* renderer2D_static_batch_create(u32 capacity); // NULL if capacity is over RENDERER2D_MAX_BATCH_QUADS
+void renderer2D_static_batch_destroy(renderer2D_static_batch* batch);
+u8 renderer2D_static_batch_set(renderer2D_static_batch* batch, u32 index, const sprite_instance* sprite); // Index up to count appends, false if full or out of pages
+void renderer2D_static_batch_truncate(renderer2D_static_batch* batch, u32 count);
+u32 renderer2D_static_batch_count(const renderer2D_static_batch* batch);
+void renderer2D_draw_static_batch(renderer2D_static_batch* batch); // Deferred batches are drawn as they are when the queue is flushed
+void renderer2D_set_scissor(i32 x, i32 y, i32 width, i32 height); // Window pixels, origin at the bottom left
+void renderer2D_disable_scissor();
 void renderer2D_end_batch();
-void renderer2D_flush();
+void renderer2D_flush(); // Draws what is batched so far, without presenting
 void renderer2D_shutdown();
\ No newline at end of file
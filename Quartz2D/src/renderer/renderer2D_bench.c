@@ -0,0 +1,98 @@
+#include <renderer/renderer2D_bench.h>
+#include <renderer/renderer2D.h>
+#include <platform/platform.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef enum {
+    BENCH_MODE_PER_CALL,
+    BENCH_MODE_BULK,
+    BENCH_MODE_BULK_DEFERRED,
+    BENCH_MODE_COUNT
+} bench_mode;
+
+static const char* bench_mode_names[BENCH_MODE_COUNT] = {
+    "per call",
+    "bulk",
+    "bulk deferred"
+};
+
+// -- INTERNAL FUNCTIONS --
+
+// Deterministic so every run draws the same scene
+static f32 internal_random(u32* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return (f32)(*state >> 8) / 16777216.0f;
+}
+
+static void internal_submit(bench_mode mode, const sprite_instance* sprites, u32 count) {
+    if (mode != BENCH_MODE_PER_CALL) {
+        renderer2D_draw_sprites(sprites, count);
+        return;
+    }
+
+    for (u32 i = 0; i < count; i++) {
+        const sprite_instance* s = &sprites[i];
+        renderer2D_draw_rotated_quad_atlas(s->x, s->y, s->width, s->height, s->texture, &s->rect, s->color, s->rotation, s->z);
+    }
+}
+
+// -- INTERNAL FUNCTIONS --
+
+i32 renderer2D_bench_run(i32 width, i32 height, u32 quad_count, u32 frames) {
+    sprite_instance* sprites = malloc(sizeof(sprite_instance) * quad_count);
+    if (!sprites) {
+        printf("Failed to allocate %u sprites!\n", quad_count);
+        return -1;
+    }
+
+    u32 seed = 12345;
+    for (u32 i = 0; i < quad_count; i++) {
+        sprite_instance* s = &sprites[i];
+        s->x = internal_random(&seed) * width;
+        s->y = internal_random(&seed) * height;
+        s->width = 4.0f + internal_random(&seed) * 28.0f;
+        s->height = 4.0f + internal_random(&seed) * 28.0f;
+        s->rotation = (internal_random(&seed) - 0.5f) * 12.0f;
+        s->z = internal_random(&seed) * 10.0f;
+        s->texture = -1;
+        s->rect = (uv_rect){ 0.0f, 0.0f, 1.0f, 1.0f };
+        s->color = (color4){ internal_random(&seed), internal_random(&seed), internal_random(&seed), 1.0f };
+    }
+
+    printf("renderer2D bench: %u quads, %u frames\n", quad_count, frames);
+
+    for (u32 mode = 0; mode < BENCH_MODE_COUNT; mode++) {
+        renderer2D_set_deferred(mode == BENCH_MODE_BULK_DEFERRED);
+
+        // Submission is timed on its own, the frame time also covers the queue, the GPU and the swap
+        f64 submit_ms = 0.0;
+        f64 frame_start = platform_get_elapsed_time_ms();
+
+        for (u32 frame = 0; frame < frames; frame++) {
+            renderer2D_begin_frame();
+
+            f64 submit_start = platform_get_elapsed_time_ms();
+            internal_submit((bench_mode)mode, sprites, quad_count);
+            submit_ms += platform_get_elapsed_time_ms() - submit_start;
+
+            renderer2D_end_frame();
+        }
+
+        f64 frame_ms = platform_get_elapsed_time_ms() - frame_start;
+        f64 quads = (f64)quad_count * frames;
+
+        renderer2D_frame_stats stats;
+        renderer2D_get_frame_stats(&stats);
+
+        printf("  %-14s submit %8.3f ms/frame %8.2f Mquads/s | frame %8.3f ms %8.2f Mquads/s | %u draw calls\n",
+               bench_mode_names[mode],
+               submit_ms / frames, submit_ms > 0.0 ? quads / (submit_ms * 1000.0) : 0.0,
+               frame_ms / frames, frame_ms > 0.0 ? quads / (frame_ms * 1000.0) : 0.0,
+               stats.draw_calls);
+    }
+
+    free(sprites);
+    return 0;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <common.h>
+
+// Microbenchmark run with --bench, compares quads per second of one draw call per quad against
+// renderer2D_draw_sprites. Needs an initialized renderer and job system, vsync should be off. Quads are
+// scattered over a width by height screen.
+i32 renderer2D_bench_run(i32 width, i32 height, u32 quad_count, u32 frames);
@@ -2,8 +2,9 @@
 in vec4 vColor;
 in vec2 vTexCoord;
 flat in int vTexIndex;
+flat in int vTexLayer;
 
-uniform sampler2D u_Textures[8];
+uniform sampler2DArray u_Textures[8]; // Texture pages, vTexLayer picks the texture inside one
 
 out vec4 FragColor;
 
@@ -11,5 +12,5 @@ void main() {
     if (vTexIndex < 0)
         FragColor = vColor; // Use pure color
     else
-        FragColor = texture(u_Textures[vTexIndex], vTexCoord) * vColor;
+        FragColor = texture(u_Textures[vTexIndex], vec3(vTexCoord, vTexLayer)) * vColor;
 }
\ No newline at end of file
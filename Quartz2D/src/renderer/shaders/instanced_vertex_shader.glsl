@@ -0,0 +1,30 @@
+#version 330 core
+
+layout (location = 0) in vec2 aCorner;         // Unit quad corner, -0.5 to 0.5
+layout (location = 1) in vec2 aCenter;         // Per instance from here on
+layout (location = 2) in vec2 aSize;
+layout (location = 3) in vec2 aRotationDepth;  // Radians, z
+layout (location = 4) in vec4 aUVRect;         // u0, v0, u1, v1
+layout (location = 5) in vec4 aColor;
+layout (location = 6) in int aTexIndex;
+layout (location = 7) in int aTexLayer;
+
+out vec4 vColor;
+out vec2 vTexCoord;
+flat out int vTexIndex;
+flat out int vTexLayer;
+
+uniform mat4 uProjection;
+
+void main() {
+	float c = cos(aRotationDepth.x);
+	float s = sin(aRotationDepth.x);
+	vec2 local = aCorner * aSize;
+	vec2 position = aCenter + vec2(local.x * c - local.y * s, local.x * s + local.y * c);
+
+	vColor = aColor;
+	vTexCoord = mix(aUVRect.xy, aUVRect.zw, aCorner + 0.5);
+	vTexIndex = aTexIndex < 8 ? aTexIndex : -1; // 255 for no texture
+	vTexLayer = aTexLayer;
+	gl_Position = uProjection * vec4(position, aRotationDepth.y, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+#version 330 core
+
+uniform sampler2D uTarget; // Scene at logical resolution
+uniform vec2 uOffset;      // Sub-pixel part of the camera, in window pixels
+uniform float uScale;      // Window pixels per logical pixel
+
+out vec4 FragColor;
+
+void main() {
+    // Nearest neighbour, every window pixel copies exactly one logical pixel
+    FragColor = texelFetch(uTarget, ivec2((gl_FragCoord.xy + uOffset) / uScale), 0);
+}
\ No newline at end of file
@@ -1,19 +1,24 @@
 #version 330 core
 
-layout (location = 0) in vec3 aPosition;
-layout (location = 1) in vec4 aColor;
-layout (location = 2) in vec2 aTexCoord;
-layout (location = 3) in int aTexIndex;
+layout (location = 0) in vec2 aPosition;
+layout (location = 1) in float aDepth;
+layout (location = 2) in vec4 aColor;
+layout (location = 3) in vec2 aTexCoord;
+layout (location = 4) in int aTexIndex;
+layout (location = 5) in int aTexLayer;
 
 out vec4 vColor;
 out vec2 vTexCoord;
 flat out int vTexIndex;
+flat out int vTexLayer;
 
 uniform mat4 uProjection;
+uniform float uDepthScale; // Packed vertices store depth normalized
 
 void main() {
 	vColor = aColor;
 	vTexCoord = aTexCoord;
-	vTexIndex = aTexIndex;
-	gl_Position = uProjection * vec4(aPosition, 1.0);
+	vTexIndex = aTexIndex < 8 ? aTexIndex : -1; // Packed vertices use 255 for no texture
+	vTexLayer = aTexLayer;
+	gl_Position = uProjection * vec4(aPosition, aDepth * uDepthScale, 1.0);
 }
\ No newline at end of file
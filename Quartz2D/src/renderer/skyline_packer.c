@@ -0,0 +1,140 @@
+#include <renderer/skyline_packer.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// -- INTERNAL FUNCTIONS --
+
+// Height the rect would sit at if its left edge is on node index, -1 if it runs off the packer
+static i32 internal_fit(const skyline_packer* packer, u32 index, i32 width, i32 height) {
+    i32 x = packer->nodes[index].x;
+    if (x + width > packer->width) return -1;
+
+    i32 y = 0;
+    i32 remaining = width;
+    for (u32 i = index; remaining > 0; i++) {
+        if (packer->nodes[i].y > y) y = packer->nodes[i].y;
+        if (y + height > packer->height) return -1;
+        remaining -= packer->nodes[i].width;
+    }
+
+    return y;
+}
+
+// Area between the skyline and the bottom of the rect, wasted once the rect is placed
+static i64 internal_waste(const skyline_packer* packer, u32 index, i32 width, i32 y) {
+    i64 waste = 0;
+    i32 remaining = width;
+    for (u32 i = index; remaining > 0; i++) {
+        i32 span = packer->nodes[i].width < remaining ? packer->nodes[i].width : remaining;
+        waste += (i64)(y - packer->nodes[i].y) * span;
+        remaining -= span;
+    }
+    return waste;
+}
+
+static u8 internal_reserve_nodes(skyline_packer* packer, u32 count) {
+    if (count <= packer->node_capacity) return true;
+
+    u32 new_capacity = packer->node_capacity * 2;
+    if (new_capacity < count) new_capacity = count;
+
+    skyline_node* nodes = realloc(packer->nodes, sizeof(skyline_node) * new_capacity);
+    if (!nodes) return false;
+
+    packer->nodes = nodes;
+    packer->node_capacity = new_capacity;
+    return true;
+}
+
+// -- INTERNAL FUNCTIONS --
+
+// -- SKYLINE PACKER FUNCTIONS --
+
+u8 skyline_packer_init(skyline_packer* packer, i32 width, i32 height) {
+    memset(packer, 0, sizeof(skyline_packer));
+    packer->width = width;
+    packer->height = height;
+
+    if (!internal_reserve_nodes(packer, 16)) return false;
+
+    skyline_packer_reset(packer);
+    return true;
+}
+
+void skyline_packer_free(skyline_packer* packer) {
+    free(packer->nodes);
+    memset(packer, 0, sizeof(skyline_packer));
+}
+
+void skyline_packer_reset(skyline_packer* packer) {
+    packer->nodes[0] = (skyline_node){ 0, 0, packer->width };
+    packer->node_count = 1;
+    packer->used_area = 0;
+}
+
+u8 skyline_packer_insert(skyline_packer* packer, i32 width, i32 height, i32* out_x, i32* out_y) {
+    if (width <= 0 || height <= 0) return false;
+
+    i32 best_index = -1;
+    i32 best_y = 0;
+    i64 best_waste = 0;
+
+    for (u32 i = 0; i < packer->node_count; i++) {
+        i32 y = internal_fit(packer, i, width, height);
+        if (y < 0) continue;
+
+        i64 waste = internal_waste(packer, i, width, y);
+        if (best_index == -1 || y < best_y || (y == best_y && waste < best_waste)) {
+            best_index = (i32)i;
+            best_y = y;
+            best_waste = waste;
+        }
+    }
+
+    if (best_index == -1) return false;
+    if (!internal_reserve_nodes(packer, packer->node_count + 1)) return false;
+
+    i32 x = packer->nodes[best_index].x;
+
+    // The rect becomes a new segment, the segments it covers are shrunk or removed
+    memmove(&packer->nodes[best_index + 1], &packer->nodes[best_index], sizeof(skyline_node) * (packer->node_count - best_index));
+    packer->nodes[best_index] = (skyline_node){ x, best_y + height, width };
+    packer->node_count++;
+
+    u32 i = (u32)best_index + 1;
+    while (i < packer->node_count) {
+        skyline_node* node = &packer->nodes[i];
+        i32 covered = x + width - node->x;
+        if (covered <= 0) break;
+
+        if (covered < node->width) {
+            node->x += covered;
+            node->width -= covered;
+            break;
+        }
+
+        memmove(node, node + 1, sizeof(skyline_node) * (packer->node_count - i - 1));
+        packer->node_count--;
+    }
+
+    // Merge neighbours at the same height so the skyline stays short
+    for (u32 j = 0; j + 1 < packer->node_count;) {
+        if (packer->nodes[j].y == packer->nodes[j + 1].y) {
+            packer->nodes[j].width += packer->nodes[j + 1].width;
+            memmove(&packer->nodes[j + 1], &packer->nodes[j + 2], sizeof(skyline_node) * (packer->node_count - j - 2));
+            packer->node_count--;
+        }
+        else {
+            j++;
+        }
+    }
+
+    packer->used_area += (u64)width * (u64)height;
+
+    *out_x = x;
+    *out_y = best_y;
+    return true;
+}
+
+// -- SKYLINE PACKER FUNCTIONS --
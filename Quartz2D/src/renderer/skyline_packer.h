@@ -0,0 +1,27 @@
+#pragma once
+
+#include <common.h>
+
+// Skyline rectangle packer. The packed area is described by its top outline (the skyline), a list of
+// horizontal segments sorted by x. A rect goes where it ends up lowest, ties go to the segment it wastes
+// the least space above. Rects can be added at any time, space is only given back by a reset.
+
+typedef struct {
+    i32 x, y, width;
+} skyline_node;
+
+typedef struct {
+    i32 width;
+    i32 height;
+    skyline_node* nodes;
+    u32 node_count;
+    u32 node_capacity;
+    u64 used_area;
+} skyline_packer;
+
+u8 skyline_packer_init(skyline_packer* packer, i32 width, i32 height);
+void skyline_packer_free(skyline_packer* packer);
+void skyline_packer_reset(skyline_packer* packer);
+
+// Returns false if the rect doesn't fit anywhere
+u8 skyline_packer_insert(skyline_packer* packer, i32 width, i32 height, i32* out_x, i32* out_y);
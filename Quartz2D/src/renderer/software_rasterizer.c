@@ -0,0 +1,441 @@
+#include <renderer/software_rasterizer.h>
+#include <core/job_system.h>
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define SOFTWARE_RASTERIZER_SIMD
+#include <emmintrin.h>
+#endif
+
+// -- INTERNAL STRUCTURES --
+
+#define SOFTWARE_RASTERIZER_INITIAL_QUADS 1024
+
+// A submitted quad ready to be filled. s and t are the quad's own coordinates, 0 to 1 along its edges,
+// written as planes over the framebuffer so a pixel center maps to them with two multiply-adds.
+typedef struct {
+    f32 s_origin, ds_dx, ds_dy;
+    f32 t_origin, dt_dx, dt_dy;
+    f32 u0, du, v0, dv;  // Texel coordinates at s, t = 0 and their change up to s, t = 1
+    f32 z;
+    u8 color[4];
+    const u8* texels;
+    i32 texture_size;
+    i32 min_x, min_y, max_x, max_y;  // Inclusive pixel bounds, clipped to the framebuffer and the scissor
+} raster_quad;
+
+typedef struct {
+    i32 width, height;
+    u8* pixels;
+    f32* depth;
+
+    u8 clear_color[4];
+    u8 clear_pending;
+
+    u8 scissor_enabled;
+    i32 scissor_min_x, scissor_min_y, scissor_max_x, scissor_max_y;  // Inclusive
+
+    raster_quad* quads;
+    u32 quad_count;
+    u32 quad_capacity;
+
+    // Quad indices of each tile, tile n owns tile_quads[tile_offsets[n]] up to tile_offsets[n + 1]
+    u32 tiles_x, tiles_y;
+    u32* tile_offsets;
+    u32* tile_cursors;
+    u32* tile_quads;
+    u32 tile_quad_capacity;
+    u8 binned;  // False if the bins didn't fit in memory, every tile then walks every quad
+} software_rasterizer_data;
+
+static software_rasterizer_data raster;
+
+// -- INTERNAL STRUCTURES --
+
+// -- INTERNAL FUNCTIONS --
+
+// Exact a * b / 255 rounded, the same on both paths
+static u8 internal_mul8(u32 a, u32 b) {
+    u32 t = a * b + 128;
+    return (u8)((t + (t >> 8)) >> 8);
+}
+
+static i32 internal_clamp(i32 value, i32 min, i32 max) {
+    return value < min ? min : (value > max ? max : value);
+}
+
+static const u8* internal_texel(const raster_quad* q, f32 s, f32 t) {
+    i32 x = internal_clamp((i32)(q->u0 + s * q->du), 0, q->texture_size - 1);
+    i32 y = internal_clamp((i32)(q->v0 + t * q->dv), 0, q->texture_size - 1);
+    return q->texels + ((size_t)y * q->texture_size + x) * 4;
+}
+
+static void internal_fill_pixel(const raster_quad* q, u8* dst, f32* depth, f32 s_row, f32 t_row, i32 x) {
+    f32 center = (f32)x + 0.5f;
+    f32 s = s_row + q->ds_dx * center;
+    f32 t = t_row + q->dt_dx * center;
+    if (!(s >= 0.0f && s < 1.0f && t >= 0.0f && t < 1.0f && q->z > *depth)) return;
+
+    u8 src[4];
+    if (q->texels) {
+        const u8* texel = internal_texel(q, s, t);
+        for (i32 c = 0; c < 4; c++) {
+            src[c] = internal_mul8(texel[c], q->color[c]);
+        }
+    }
+    else {
+        memcpy(src, q->color, 4);
+    }
+
+    u32 alpha = src[3];
+    for (i32 c = 0; c < 4; c++) {
+        dst[c] = (u8)(internal_mul8(src[c], alpha) + internal_mul8(dst[c], 255 - alpha));
+    }
+    *depth = q->z;
+}
+
+#ifdef SOFTWARE_RASTERIZER_SIMD
+
+static __m128i internal_mul8x8(__m128i a, __m128i b) {
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+// Blends the RGBA8 source of two pixels over the destination, 16 bits per channel
+static __m128i internal_blend2(__m128i src, __m128i dst) {
+    __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src, 0xFF), 0xFF);
+    __m128i inv_alpha = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+    return _mm_add_epi16(internal_mul8x8(src, alpha), internal_mul8x8(dst, inv_alpha));
+}
+
+// Four pixels starting at x, the same math as internal_fill_pixel lane by lane
+static void internal_fill_pixels4(const raster_quad* q, u8* dst, f32* depth, f32 s_row, f32 t_row, i32 x) {
+    __m128 center = _mm_add_ps(_mm_set1_ps((f32)x), _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f));
+    __m128 s = _mm_add_ps(_mm_set1_ps(s_row), _mm_mul_ps(_mm_set1_ps(q->ds_dx), center));
+    __m128 t = _mm_add_ps(_mm_set1_ps(t_row), _mm_mul_ps(_mm_set1_ps(q->dt_dx), center));
+
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 z = _mm_set1_ps(q->z);
+    __m128 old_depth = _mm_loadu_ps(depth);
+
+    __m128 mask = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(s, zero), _mm_cmplt_ps(s, one)),
+                             _mm_and_ps(_mm_cmpge_ps(t, zero), _mm_cmplt_ps(t, one)));
+    mask = _mm_and_ps(mask, _mm_cmpgt_ps(z, old_depth));
+    if (_mm_movemask_ps(mask) == 0) return;
+
+    __m128i color = _mm_set_epi16(q->color[3], q->color[2], q->color[1], q->color[0],
+                                  q->color[3], q->color[2], q->color[1], q->color[0]);
+    __m128i src_lo = color;
+    __m128i src_hi = color;
+
+    if (q->texels) {
+        // No gather before AVX2, the texel addresses are computed wide and the loads done one by one
+        i32 tx[4];
+        i32 ty[4];
+        _mm_storeu_si128((__m128i*)tx, _mm_cvttps_epi32(_mm_add_ps(_mm_set1_ps(q->u0), _mm_mul_ps(s, _mm_set1_ps(q->du)))));
+        _mm_storeu_si128((__m128i*)ty, _mm_cvttps_epi32(_mm_add_ps(_mm_set1_ps(q->v0), _mm_mul_ps(t, _mm_set1_ps(q->dv)))));
+
+        u32 texels[4];
+        for (i32 i = 0; i < 4; i++) {
+            i32 texel_x = internal_clamp(tx[i], 0, q->texture_size - 1);
+            i32 texel_y = internal_clamp(ty[i], 0, q->texture_size - 1);
+            memcpy(&texels[i], q->texels + ((size_t)texel_y * q->texture_size + texel_x) * 4, 4);
+        }
+
+        __m128i texel = _mm_loadu_si128((const __m128i*)texels);
+        src_lo = internal_mul8x8(_mm_unpacklo_epi8(texel, _mm_setzero_si128()), color);
+        src_hi = internal_mul8x8(_mm_unpackhi_epi8(texel, _mm_setzero_si128()), color);
+    }
+
+    __m128i old = _mm_loadu_si128((const __m128i*)dst);
+    __m128i out_lo = internal_blend2(src_lo, _mm_unpacklo_epi8(old, _mm_setzero_si128()));
+    __m128i out_hi = internal_blend2(src_hi, _mm_unpackhi_epi8(old, _mm_setzero_si128()));
+    __m128i out = _mm_packus_epi16(out_lo, out_hi);
+
+    __m128i pixel_mask = _mm_castps_si128(mask);
+    _mm_storeu_si128((__m128i*)dst, _mm_or_si128(_mm_and_si128(pixel_mask, out), _mm_andnot_si128(pixel_mask, old)));
+    _mm_storeu_ps(depth, _mm_or_ps(_mm_and_ps(mask, z), _mm_andnot_ps(mask, old_depth)));
+}
+
+#endif
+
+// Narrows [lo, hi] to the pixel centers where row + d * x is in [0, 1), false if none of the row is
+static u8 internal_clip_span(f32 row, f32 d, f32* lo, f32* hi) {
+    if (d == 0.0f) return row >= 0.0f && row < 1.0f;
+
+    f32 a = -row / d;
+    f32 b = (1.0f - row) / d;
+    if (a > b) {
+        f32 swap = a;
+        a = b;
+        b = swap;
+    }
+
+    if (a > *lo) *lo = a;
+    if (b < *hi) *hi = b;
+    return true;
+}
+
+// Fills the part of the quad inside the inclusive pixel rect. The span of each row is found analytically and
+// widened by a pixel on both sides, the per pixel test then decides the edges exactly.
+static void internal_raster_quad(const raster_quad* q, i32 min_x, i32 min_y, i32 max_x, i32 max_y) {
+    if (q->min_x > min_x) min_x = q->min_x;
+    if (q->min_y > min_y) min_y = q->min_y;
+    if (q->max_x < max_x) max_x = q->max_x;
+    if (q->max_y < max_y) max_y = q->max_y;
+
+    for (i32 y = min_y; y <= max_y; y++) {
+        f32 center = (f32)y + 0.5f;
+        f32 s_row = q->s_origin + q->ds_dy * center;
+        f32 t_row = q->t_origin + q->dt_dy * center;
+
+        f32 lo = (f32)min_x + 0.5f;
+        f32 hi = (f32)max_x + 0.5f;
+        if (!internal_clip_span(s_row, q->ds_dx, &lo, &hi) || !internal_clip_span(t_row, q->dt_dx, &lo, &hi) || lo > hi + 1.0f) continue;
+
+        i32 first = internal_clamp((i32)floorf(lo - 0.5f) - 1, min_x, max_x);
+        i32 last = internal_clamp((i32)ceilf(hi - 0.5f) + 1, min_x, max_x);
+
+        size_t row = (size_t)y * raster.width;
+        u8* dst = raster.pixels + (row + first) * 4;
+        f32* depth = raster.depth + row + first;
+
+        i32 x = first;
+#ifdef SOFTWARE_RASTERIZER_SIMD
+        for (; x + 3 <= last; x += 4, dst += 16, depth += 4) {
+            internal_fill_pixels4(q, dst, depth, s_row, t_row, x);
+        }
+#endif
+        for (; x <= last; x++, dst += 4, depth++) {
+            internal_fill_pixel(q, dst, depth, s_row, t_row, x);
+        }
+    }
+}
+
+static void internal_raster_tiles(void* data, u32 begin, u32 end) {
+    (void)data;
+
+    for (u32 tile = begin; tile < end; tile++) {
+        i32 min_x = (i32)(tile % raster.tiles_x) * SOFTWARE_RASTERIZER_TILE_SIZE;
+        i32 min_y = (i32)(tile / raster.tiles_x) * SOFTWARE_RASTERIZER_TILE_SIZE;
+        i32 max_x = min_x + SOFTWARE_RASTERIZER_TILE_SIZE - 1 < raster.width - 1 ? min_x + SOFTWARE_RASTERIZER_TILE_SIZE - 1 : raster.width - 1;
+        i32 max_y = min_y + SOFTWARE_RASTERIZER_TILE_SIZE - 1 < raster.height - 1 ? min_y + SOFTWARE_RASTERIZER_TILE_SIZE - 1 : raster.height - 1;
+
+        if (raster.clear_pending) {
+            for (i32 y = min_y; y <= max_y; y++) {
+                size_t row = (size_t)y * raster.width;
+                for (i32 x = min_x; x <= max_x; x++) {
+                    memcpy(raster.pixels + (row + x) * 4, raster.clear_color, 4);
+                    raster.depth[row + x] = -FLT_MAX;
+                }
+            }
+        }
+
+        if (raster.binned) {
+            for (u32 i = raster.tile_offsets[tile]; i < raster.tile_offsets[tile + 1]; i++) {
+                internal_raster_quad(&raster.quads[raster.tile_quads[i]], min_x, min_y, max_x, max_y);
+            }
+        }
+        else {
+            for (u32 i = 0; i < raster.quad_count; i++) {
+                internal_raster_quad(&raster.quads[i], min_x, min_y, max_x, max_y);
+            }
+        }
+    }
+}
+
+// Counts the quads of every tile, then writes their indices in submission order
+static u8 internal_bin_quads() {
+    u32 tile_count = raster.tiles_x * raster.tiles_y;
+    memset(raster.tile_offsets, 0, sizeof(u32) * (tile_count + 1));
+
+    for (u32 i = 0; i < raster.quad_count; i++) {
+        const raster_quad* q = &raster.quads[i];
+        for (i32 ty = q->min_y / SOFTWARE_RASTERIZER_TILE_SIZE; ty <= q->max_y / SOFTWARE_RASTERIZER_TILE_SIZE; ty++) {
+            for (i32 tx = q->min_x / SOFTWARE_RASTERIZER_TILE_SIZE; tx <= q->max_x / SOFTWARE_RASTERIZER_TILE_SIZE; tx++) {
+                raster.tile_offsets[(u32)ty * raster.tiles_x + (u32)tx + 1]++;
+            }
+        }
+    }
+
+    for (u32 tile = 0; tile < tile_count; tile++) {
+        raster.tile_offsets[tile + 1] += raster.tile_offsets[tile];
+    }
+
+    u32 total = raster.tile_offsets[tile_count];
+    if (total > raster.tile_quad_capacity) {
+        u32* tile_quads = (u32*)realloc(raster.tile_quads, sizeof(u32) * total);
+        if (!tile_quads) return false;
+
+        raster.tile_quads = tile_quads;
+        raster.tile_quad_capacity = total;
+    }
+
+    memcpy(raster.tile_cursors, raster.tile_offsets, sizeof(u32) * tile_count);
+
+    for (u32 i = 0; i < raster.quad_count; i++) {
+        const raster_quad* q = &raster.quads[i];
+        for (i32 ty = q->min_y / SOFTWARE_RASTERIZER_TILE_SIZE; ty <= q->max_y / SOFTWARE_RASTERIZER_TILE_SIZE; ty++) {
+            for (i32 tx = q->min_x / SOFTWARE_RASTERIZER_TILE_SIZE; tx <= q->max_x / SOFTWARE_RASTERIZER_TILE_SIZE; tx++) {
+                raster.tile_quads[raster.tile_cursors[(u32)ty * raster.tiles_x + (u32)tx]++] = i;
+            }
+        }
+    }
+
+    return true;
+}
+
+// False for quads that cover no pixel, degenerate ones included
+static u8 internal_setup_quad(const software_quad* quad, raster_quad* out) {
+    f32 e1_x = quad->corners[1][0] - quad->corners[0][0];
+    f32 e1_y = quad->corners[1][1] - quad->corners[0][1];
+    f32 e2_x = quad->corners[3][0] - quad->corners[0][0];
+    f32 e2_y = quad->corners[3][1] - quad->corners[0][1];
+
+    f32 det = e1_x * e2_y - e1_y * e2_x;
+    if (fabsf(det) < 1e-6f) return false;
+
+    f32 min_x = quad->corners[0][0], max_x = min_x;
+    f32 min_y = quad->corners[0][1], max_y = min_y;
+    for (i32 i = 1; i < 4; i++) {
+        if (quad->corners[i][0] < min_x) min_x = quad->corners[i][0];
+        if (quad->corners[i][0] > max_x) max_x = quad->corners[i][0];
+        if (quad->corners[i][1] < min_y) min_y = quad->corners[i][1];
+        if (quad->corners[i][1] > max_y) max_y = quad->corners[i][1];
+    }
+
+    i32 clip_min_x = raster.scissor_enabled ? raster.scissor_min_x : 0;
+    i32 clip_min_y = raster.scissor_enabled ? raster.scissor_min_y : 0;
+    i32 clip_max_x = raster.scissor_enabled ? raster.scissor_max_x : raster.width - 1;
+    i32 clip_max_y = raster.scissor_enabled ? raster.scissor_max_y : raster.height - 1;
+
+    // Clamped as floats first, far off screen corners are out of the range of an i32
+    out->min_x = (i32)floorf(min_x > (f32)clip_min_x ? min_x : (f32)clip_min_x);
+    out->min_y = (i32)floorf(min_y > (f32)clip_min_y ? min_y : (f32)clip_min_y);
+    out->max_x = (i32)ceilf(max_x < (f32)clip_max_x ? max_x : (f32)clip_max_x);
+    out->max_y = (i32)ceilf(max_y < (f32)clip_max_y ? max_y : (f32)clip_max_y);
+    if (out->min_x > out->max_x || out->min_y > out->max_y) return false;
+
+    // Solving p = c0 + s * e1 + t * e2 for s and t
+    f32 inv_det = 1.0f / det;
+    out->ds_dx = e2_y * inv_det;
+    out->ds_dy = -e2_x * inv_det;
+    out->s_origin = -(quad->corners[0][0] * out->ds_dx + quad->corners[0][1] * out->ds_dy);
+    out->dt_dx = -e1_y * inv_det;
+    out->dt_dy = e1_x * inv_det;
+    out->t_origin = -(quad->corners[0][0] * out->dt_dx + quad->corners[0][1] * out->dt_dy);
+
+    f32 size = (f32)quad->texture_size;
+    out->u0 = quad->rect.u0 * size;
+    out->du = (quad->rect.u1 - quad->rect.u0) * size;
+    out->v0 = quad->rect.v0 * size;
+    out->dv = (quad->rect.v1 - quad->rect.v0) * size;
+
+    out->z = quad->z;
+    memcpy(out->color, quad->color, 4);
+    out->texels = quad->texture_size > 0 ? quad->texels : NULL;
+    out->texture_size = quad->texture_size;
+
+    return true;
+}
+
+// -- INTERNAL FUNCTIONS --
+
+// -- SOFTWARE RASTERIZER FUNCTIONS --
+
+u8 software_rasterizer_init(i32 width, i32 height) {
+    memset(&raster, 0, sizeof(raster));
+    if (width <= 0 || height <= 0) return false;
+
+    raster.width = width;
+    raster.height = height;
+    raster.tiles_x = (u32)(width + SOFTWARE_RASTERIZER_TILE_SIZE - 1) / SOFTWARE_RASTERIZER_TILE_SIZE;
+    raster.tiles_y = (u32)(height + SOFTWARE_RASTERIZER_TILE_SIZE - 1) / SOFTWARE_RASTERIZER_TILE_SIZE;
+
+    u32 tile_count = raster.tiles_x * raster.tiles_y;
+    raster.pixels = (u8*)calloc((size_t)width * height, 4);
+    raster.depth = (f32*)malloc(sizeof(f32) * (size_t)width * height);
+    raster.quads = (raster_quad*)malloc(sizeof(raster_quad) * SOFTWARE_RASTERIZER_INITIAL_QUADS);
+    raster.tile_offsets = (u32*)malloc(sizeof(u32) * (tile_count + 1));
+    raster.tile_cursors = (u32*)malloc(sizeof(u32) * tile_count);
+    if (!raster.pixels || !raster.depth || !raster.quads || !raster.tile_offsets || !raster.tile_cursors) {
+        software_rasterizer_shutdown();
+        return false;
+    }
+
+    raster.quad_capacity = SOFTWARE_RASTERIZER_INITIAL_QUADS;
+
+    const u8 black[4] = { 0, 0, 0, 255 };
+    software_rasterizer_clear(black);
+    return true;
+}
+
+void software_rasterizer_shutdown() {
+    free(raster.pixels);
+    free(raster.depth);
+    free(raster.quads);
+    free(raster.tile_offsets);
+    free(raster.tile_cursors);
+    free(raster.tile_quads);
+    memset(&raster, 0, sizeof(raster));
+}
+
+void software_rasterizer_clear(const u8 color[4]) {
+    // Quads before the clear would be drawn over by it
+    raster.quad_count = 0;
+    memcpy(raster.clear_color, color, 4);
+    raster.clear_pending = true;
+}
+
+void software_rasterizer_set_scissor(u8 enabled, i32 x, i32 y, i32 width, i32 height) {
+    raster.scissor_enabled = enabled;
+    raster.scissor_min_x = x < 0 ? 0 : x;
+    raster.scissor_min_y = y < 0 ? 0 : y;
+    raster.scissor_max_x = x + width - 1 < raster.width - 1 ? x + width - 1 : raster.width - 1;
+    raster.scissor_max_y = y + height - 1 < raster.height - 1 ? y + height - 1 : raster.height - 1;
+}
+
+void software_rasterizer_submit(const software_quad* quad) {
+    if (raster.quad_count == raster.quad_capacity) {
+        raster_quad* quads = (raster_quad*)realloc(raster.quads, sizeof(raster_quad) * raster.quad_capacity * 2);
+        if (quads) {
+            raster.quads = quads;
+            raster.quad_capacity *= 2;
+        }
+        else {
+            software_rasterizer_flush();
+        }
+    }
+
+    if (internal_setup_quad(quad, &raster.quads[raster.quad_count])) {
+        raster.quad_count++;
+    }
+}
+
+void software_rasterizer_flush() {
+    if (raster.quad_count == 0 && !raster.clear_pending) return;
+
+    raster.binned = internal_bin_quads();
+
+    u32 tile_count = raster.tiles_x * raster.tiles_y;
+    if (tile_count > 1 && job_system_thread_count() > 1) {
+        job_system_parallel_for(tile_count, 1, internal_raster_tiles, NULL);
+    }
+    else {
+        internal_raster_tiles(NULL, 0, tile_count);
+    }
+
+    raster.quad_count = 0;
+    raster.clear_pending = false;
+}
+
+const u8* software_rasterizer_pixels() {
+    return raster.pixels;
+}
+
+// -- SOFTWARE RASTERIZER FUNCTIONS --
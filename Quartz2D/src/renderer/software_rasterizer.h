@@ -0,0 +1,39 @@
+#pragma once
+
+#include <common.h>
+#include <renderer/texture_atlas.h>
+
+// CPU rasterizer behind the software backend of renderer2D. Quads are recorded as they are submitted and
+// drawn when the rasterizer is flushed: every quad is binned into the 64x64 tiles it touches, then the tiles
+// are filled in parallel on the job system, each one drawing its quads in submission order. A tile is only
+// ever touched by one thread, so the image doesn't depend on the worker count.
+// Pixels match the OpenGL backend's state: nearest sampling clamped to the edge, the texel times the quad
+// color, SRC_ALPHA / ONE_MINUS_SRC_ALPHA blending on all four channels and a depth test where a fragment
+// is drawn if its z is larger than the one stored, which every drawn fragment writes.
+// The framebuffer is RGBA8 with its first row at the bottom, like glReadPixels returns it.
+
+#define SOFTWARE_RASTERIZER_TILE_SIZE 64
+
+typedef struct {
+    f32 corners[4][2];   // Framebuffer pixels, the corners of (u0, v0), (u1, v0), (u1, v1) and (u0, v1)
+    uv_rect rect;
+    f32 z;               // Larger is nearer
+    u8 color[4];         // RGBA8, multiplied into the texel
+    const u8* texels;    // RGBA8 square of texture_size texels from v = 0, NULL to draw the color only
+    i32 texture_size;
+} software_quad;
+
+u8 software_rasterizer_init(i32 width, i32 height);
+void software_rasterizer_shutdown();
+
+// Applied at the next flush, before any quad
+void software_rasterizer_clear(const u8 color[4]);
+
+// Quads submitted afterwards are clipped to the rect, framebuffer pixels with the origin at the bottom left
+void software_rasterizer_set_scissor(u8 enabled, i32 x, i32 y, i32 width, i32 height);
+
+// The texels must stay valid until the next flush. Quads that don't fit in memory flush the ones before them.
+void software_rasterizer_submit(const software_quad* quad);
+void software_rasterizer_flush();
+
+const u8* software_rasterizer_pixels(); // width * height RGBA8, complete after a flush
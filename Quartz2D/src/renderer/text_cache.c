@@ -0,0 +1,105 @@
+#include <renderer/text_cache.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// -- INTERNAL FUNCTIONS --
+
+// FNV-1a, the length comes out of the same pass
+static u64 internal_hash_text(const char* text, u32* out_length) {
+    u64 hash = 14695981039346656037ull;
+    u32 length = 0;
+
+    for (; text[length] != '\0'; length++) {
+        hash ^= (u8)text[length];
+        hash *= 1099511628211ull;
+    }
+
+    *out_length = length;
+    return hash;
+}
+
+static u8 internal_layout(text_run* run, const bitmap_font* font, const char* text, u32 length) {
+    if (length + 1 > run->text_capacity) {
+        char* copy = (char*)realloc(run->text, length + 1);
+        if (!copy) return false;
+
+        run->text = copy;
+        run->text_capacity = length + 1;
+    }
+
+    if (length > run->glyph_capacity) {
+        text_glyph* glyphs = (text_glyph*)realloc(run->glyphs, sizeof(text_glyph) * length);
+        if (!glyphs) return false;
+
+        run->glyphs = glyphs;
+        run->glyph_capacity = length;
+    }
+
+    memcpy(run->text, text, length + 1);
+
+    f32 cursor = 0.0f;
+    run->glyph_count = 0;
+
+    for (u32 i = 0; i < length; i++) {
+        bitmap_glyph glyph = bitmap_font_get_glyph(font, (u8)text[i]);
+
+        if (glyph.visible) {
+            text_glyph* out = &run->glyphs[run->glyph_count++];
+            out->x = cursor;
+            out->rect = glyph.rect;
+        }
+
+        cursor += glyph.advance;
+    }
+
+    return true;
+}
+
+// -- INTERNAL FUNCTIONS --
+
+// -- TEXT CACHE FUNCTIONS --
+
+void text_cache_init(text_cache* cache) {
+    memset(cache, 0, sizeof(text_cache));
+}
+
+void text_cache_free(text_cache* cache) {
+    for (u32 i = 0; i < TEXT_CACHE_SLOTS; i++) {
+        free(cache->runs[i].text);
+        free(cache->runs[i].glyphs);
+    }
+
+    memset(cache, 0, sizeof(text_cache));
+}
+
+const text_run* text_cache_get(text_cache* cache, const bitmap_font* font, const char* text) {
+    u32 length = 0;
+    u64 hash = internal_hash_text(text, &length);
+
+    // The font takes part in the slot so the same label in two fonts doesn't keep evicting itself
+    u64 slot_hash = hash ^ ((u64)(size_t)font * 0x9E3779B97F4A7C15ull);
+    text_run* run = &cache->runs[(slot_hash >> 32) % TEXT_CACHE_SLOTS];
+
+    // Unbuilt fonts all have version 0, their runs aren't reused since another font may have taken the address
+    if (run->text && run->hash == hash && run->font == font && run->glyph_version == font->glyph_version &&
+        font->glyph_version != 0 && strcmp(run->text, text) == 0) {
+        cache->hits++;
+        return run;
+    }
+
+    cache->misses++;
+
+    if (!internal_layout(run, font, text, length)) {
+        // A half written run must not match later
+        run->font = NULL;
+        return NULL;
+    }
+
+    run->hash = hash;
+    run->font = font;
+    run->glyph_version = font->glyph_version;
+    return run;
+}
+
+// -- TEXT CACHE FUNCTIONS --
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <common.h>
+#include <renderer/bitmap_font.h>
+
+// Laid-out text runs, so labels that don't change skip the per character work. A run only depends on the
+// string and the font's glyph table: positions are in units of the font size and relative to the origin,
+// so the same run serves any size, position and color. The cache is direct mapped, a run whose slot is
+// taken by another string is simply laid out again next time. Runs are matched by font address and glyph
+// version, versions are unique across fonts so a freed font's runs never match. Text in a font whose table
+// was never built is laid out on every call.
+
+#define TEXT_CACHE_SLOTS 256
+
+typedef struct {
+    f32 x;         // Left edge in units of the font size
+    uv_rect rect;
+} text_glyph;
+
+typedef struct {
+    u64 hash;
+    const bitmap_font* font;
+    u32 glyph_version;
+    char* text;           // Copy of the string, compared on a hash match
+    u32 text_capacity;
+    text_glyph* glyphs;   // Visible glyphs only
+    u32 glyph_count;
+    u32 glyph_capacity;
+} text_run;
+
+typedef struct {
+    text_run runs[TEXT_CACHE_SLOTS];
+    u32 hits;
+    u32 misses;
+} text_cache;
+
+void text_cache_init(text_cache* cache);
+void text_cache_free(text_cache* cache);
+
+// NULL if the run doesn't fit in memory, the run stays valid until the next call
+const text_run* text_cache_get(text_cache* cache, const bitmap_font* font, const char* text);
@@ -0,0 +1,329 @@
+#include <renderer/texture_array.h>
+#include <renderer/skyline_packer.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// -- INTERNAL STRUCTURES --
+
+#define TEXTURE_ARRAY_ATLAS_SIZE 1024               // Layer size of the shared pages every small texture is packed into
+#define TEXTURE_ARRAY_PAGE_BYTES (16 * 1024 * 1024) // Budget a page's layer count is derived from
+#define TEXTURE_ARRAY_PADDING 1                     // Border around packed textures, filled by extruding their edges
+#define TEXTURE_ARRAY_CPU_MAX_SIZE 8192             // Limits of CPU pages, there is no GPU to ask
+#define TEXTURE_ARRAY_CPU_MAX_LAYERS 64
+
+typedef struct {
+    GLuint texture;  // 0 if the page was never created or lives in CPU memory
+    u8* pixels;      // RGBA8 layers one after another, CPU pages only
+    i32 size;        // Width and height of every layer
+    u32 layer_count;
+    skyline_packer* packers;  // One per layer
+    u32* layer_textures;      // Live textures per layer, an empty layer gets its packer reset
+} texture_page;
+
+typedef struct {
+    texture_page pages[TEXTURE_ARRAY_MAX_PAGES];
+    u32 page_count;
+
+    texture_array_entry* entries;
+    u32 entry_count;
+    u32 entry_capacity;
+    i32 free_entry;  // Head of the free list, -1 if empty
+
+    u8 cpu_pages;    // Pages are kept in memory for the software rasterizer, no GL calls are made
+    i32 max_size;    // GL_MAX_TEXTURE_SIZE
+    u32 max_layers;  // GL_MAX_ARRAY_TEXTURE_LAYERS clamped to TEXTURE_ARRAY_MAX_LAYERS
+} texture_array_data;
+
+static texture_array_data textures;
+
+// -- INTERNAL STRUCTURES --
+
+// -- INTERNAL FUNCTIONS --
+
+static i32 internal_size_class(i32 width, i32 height) {
+    i32 size = TEXTURE_ARRAY_ATLAS_SIZE;
+    while (size < width || size < height) {
+        size *= 2;
+    }
+    return size < textures.max_size ? size : textures.max_size;
+}
+
+static i32 internal_create_page(i32 size) {
+    if (textures.page_count >= TEXTURE_ARRAY_MAX_PAGES) return -1;
+
+    u32 layer_count = TEXTURE_ARRAY_PAGE_BYTES / ((u32)size * (u32)size * 4);
+    if (layer_count == 0) layer_count = 1;
+    if (layer_count > textures.max_layers) layer_count = textures.max_layers;
+
+    texture_page* page = &textures.pages[textures.page_count];
+    memset(page, 0, sizeof(texture_page));
+    page->size = size;
+    page->layer_count = layer_count;
+    page->packers = calloc(layer_count, sizeof(skyline_packer));
+    page->layer_textures = calloc(layer_count, sizeof(u32));
+    if (!page->packers || !page->layer_textures) {
+        free(page->packers);
+        free(page->layer_textures);
+        return -1;
+    }
+
+    for (u32 i = 0; i < layer_count; i++) {
+        if (!skyline_packer_init(&page->packers[i], size, size)) {
+            for (u32 j = 0; j < i; j++) {
+                skyline_packer_free(&page->packers[j]);
+            }
+            free(page->packers);
+            free(page->layer_textures);
+            return -1;
+        }
+    }
+
+    if (textures.cpu_pages) {
+        // Zeroed like a fresh GL texture, sampled only where textures were uploaded
+        page->pixels = calloc((size_t)size * size * 4 * layer_count, 1);
+        if (!page->pixels) {
+            for (u32 i = 0; i < layer_count; i++) {
+                skyline_packer_free(&page->packers[i]);
+            }
+            free(page->packers);
+            free(page->layer_textures);
+            return -1;
+        }
+
+        return (i32)textures.page_count++;
+    }
+
+    glGenTextures(1, &page->texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, page->texture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, size, size, (GLsizei)layer_count, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    // Textures are packed next to each other, so there are no mipmaps that would bleed them into one another
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
+
+    return (i32)textures.page_count++;
+}
+
+// Finds room for a rect in a page of the given size class, creating a page if they are all full
+static u8 internal_allocate_rect(i32 size, i32 width, i32 height, u16* out_page, u16* out_layer, i32* out_x, i32* out_y) {
+    for (u32 i = 0; i < textures.page_count; i++) {
+        texture_page* page = &textures.pages[i];
+        if (page->size != size) continue;
+
+        for (u32 layer = 0; layer < page->layer_count; layer++) {
+            if (skyline_packer_insert(&page->packers[layer], width, height, out_x, out_y)) {
+                page->layer_textures[layer]++;
+                *out_page = (u16)i;
+                *out_layer = (u16)layer;
+                return true;
+            }
+        }
+    }
+
+    i32 page_index = internal_create_page(size);
+    if (page_index == -1) return false;
+
+    texture_page* page = &textures.pages[page_index];
+    if (!skyline_packer_insert(&page->packers[0], width, height, out_x, out_y)) return false;
+
+    page->layer_textures[0]++;
+    *out_page = (u16)page_index;
+    *out_layer = 0;
+    return true;
+}
+
+static void internal_release_rect(u16 page_index, u16 layer) {
+    texture_page* page = &textures.pages[page_index];
+    if (--page->layer_textures[layer] == 0) {
+        skyline_packer_reset(&page->packers[layer]);
+    }
+}
+
+// Uploads the pixels with their edge texels repeated over the padding, so filtering or rounding
+// at the border of a texture samples its own edge instead of a neighbour
+static u8 internal_upload_padded(const texture_page* page, u16 layer, i32 x, i32 y, i32 width, i32 height, const u8* pixels) {
+    i32 padded_width = width + 2 * TEXTURE_ARRAY_PADDING;
+    i32 padded_height = height + 2 * TEXTURE_ARRAY_PADDING;
+
+    u8* padded = malloc((size_t)padded_width * padded_height * 4);
+    if (!padded) return false;
+
+    for (i32 row = 0; row < padded_height; row++) {
+        i32 src_row = row - TEXTURE_ARRAY_PADDING;
+        src_row = src_row < 0 ? 0 : (src_row >= height ? height - 1 : src_row);
+
+        const u8* src = pixels + (size_t)src_row * width * 4;
+        u8* dst = padded + (size_t)row * padded_width * 4;
+
+        for (i32 i = 0; i < TEXTURE_ARRAY_PADDING; i++) {
+            memcpy(dst + (size_t)i * 4, src, 4);
+            memcpy(dst + (size_t)(TEXTURE_ARRAY_PADDING + width + i) * 4, src + (size_t)(width - 1) * 4, 4);
+        }
+        memcpy(dst + (size_t)TEXTURE_ARRAY_PADDING * 4, src, (size_t)width * 4);
+    }
+
+    if (page->pixels) {
+        u8* layer_pixels = page->pixels + (size_t)layer * page->size * page->size * 4;
+        for (i32 row = 0; row < padded_height; row++) {
+            memcpy(layer_pixels + ((size_t)(y + row) * page->size + x) * 4, padded + (size_t)row * padded_width * 4, (size_t)padded_width * 4);
+        }
+    }
+    else {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, page->texture);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, x, y, layer, padded_width, padded_height, 1, GL_RGBA, GL_UNSIGNED_BYTE, padded);
+    }
+
+    free(padded);
+    return true;
+}
+
+static i32 internal_allocate_entry() {
+    if (textures.free_entry != -1) {
+        i32 index = textures.free_entry;
+        textures.free_entry = textures.entries[index].next_free;
+        return index;
+    }
+
+    if (textures.entry_count == textures.entry_capacity) {
+        u32 new_capacity = textures.entry_capacity ? textures.entry_capacity * 2 : 64;
+        texture_array_entry* entries = realloc(textures.entries, sizeof(texture_array_entry) * new_capacity);
+        if (!entries) return -1;
+
+        textures.entries = entries;
+        textures.entry_capacity = new_capacity;
+    }
+
+    return (i32)textures.entry_count++;
+}
+
+// -- INTERNAL FUNCTIONS --
+
+// -- TEXTURE ARRAY FUNCTIONS --
+
+u8 texture_array_init(u8 cpu_pages) {
+    memset(&textures, 0, sizeof(textures));
+    textures.free_entry = -1;
+    textures.cpu_pages = cpu_pages;
+
+    if (cpu_pages) {
+        textures.max_size = TEXTURE_ARRAY_CPU_MAX_SIZE;
+        textures.max_layers = TEXTURE_ARRAY_CPU_MAX_LAYERS;
+        return true;
+    }
+
+    GLint max_size = 0;
+    GLint max_layers = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+    if (max_size <= 0 || max_layers <= 0) return false;
+
+    textures.max_size = max_size;
+    textures.max_layers = max_layers < TEXTURE_ARRAY_MAX_LAYERS ? (u32)max_layers : TEXTURE_ARRAY_MAX_LAYERS;
+
+    return true;
+}
+
+void texture_array_shutdown() {
+    for (u32 i = 0; i < textures.page_count; i++) {
+        texture_page* page = &textures.pages[i];
+        if (page->texture) glDeleteTextures(1, &page->texture);
+        free(page->pixels);
+
+        for (u32 layer = 0; layer < page->layer_count; layer++) {
+            skyline_packer_free(&page->packers[layer]);
+        }
+        free(page->packers);
+        free(page->layer_textures);
+    }
+
+    free(textures.entries);
+    memset(&textures, 0, sizeof(textures));
+    textures.free_entry = -1;
+}
+
+i32 texture_array_create(i32 width, i32 height, const u8* pixels) {
+    i32 padded_width = width + 2 * TEXTURE_ARRAY_PADDING;
+    i32 padded_height = height + 2 * TEXTURE_ARRAY_PADDING;
+    if (width <= 0 || height <= 0 || padded_width > textures.max_size || padded_height > textures.max_size) return -1;
+
+    i32 size = internal_size_class(padded_width, padded_height);
+
+    u16 page = 0;
+    u16 layer = 0;
+    i32 x = 0;
+    i32 y = 0;
+    if (!internal_allocate_rect(size, padded_width, padded_height, &page, &layer, &x, &y)) return -1;
+
+    i32 index = internal_allocate_entry();
+    if (index == -1 || !internal_upload_padded(&textures.pages[page], layer, x, y, width, height, pixels)) {
+        if (index != -1) {
+            textures.entries[index].width = 0;
+            textures.entries[index].next_free = textures.free_entry;
+            textures.free_entry = index;
+        }
+        internal_release_rect(page, layer);
+        return -1;
+    }
+
+    f32 inv_size = 1.0f / (f32)size;
+    x += TEXTURE_ARRAY_PADDING;
+    y += TEXTURE_ARRAY_PADDING;
+
+    texture_array_entry* entry = &textures.entries[index];
+    entry->page = page;
+    entry->layer = layer;
+    entry->width = width;
+    entry->height = height;
+    entry->rect = (uv_rect){ x * inv_size, y * inv_size, (x + width) * inv_size, (y + height) * inv_size };
+    entry->next_free = -1;
+
+    return index;
+}
+
+void texture_array_destroy(i32 texture) {
+    if (!texture_array_get(texture)) return;
+
+    // The space is given back once every texture packed into the layer is gone
+    texture_array_entry* entry = &textures.entries[texture];
+    internal_release_rect(entry->page, entry->layer);
+
+    entry->width = 0;
+    entry->next_free = textures.free_entry;
+    textures.free_entry = texture;
+}
+
+i32 texture_array_max_size() {
+    return textures.max_size - 2 * TEXTURE_ARRAY_PADDING;
+}
+
+const texture_array_entry* texture_array_get(i32 texture) {
+    if (texture < 0 || (u32)texture >= textures.entry_count) return NULL;
+
+    const texture_array_entry* entry = &textures.entries[texture];
+    return entry->width > 0 ? entry : NULL;
+}
+
+GLuint texture_array_page_texture(u32 page) {
+    return page < textures.page_count ? textures.pages[page].texture : 0;
+}
+
+const u8* texture_array_page_pixels(u32 page, u32 layer, i32* out_size) {
+    if (page >= textures.page_count || layer >= textures.pages[page].layer_count || !textures.pages[page].pixels) return NULL;
+
+    const texture_page* p = &textures.pages[page];
+    *out_size = p->size;
+    return p->pixels + (size_t)layer * p->size * p->size * 4;
+}
+
+u32 texture_array_sort_key(i32 texture) {
+    const texture_array_entry* entry = texture_array_get(texture);
+    if (!entry) return 0;
+
+    return 1 + (((u32)entry->page << 8) | entry->layer);
+}
+
+// -- TEXTURE ARRAY FUNCTIONS --
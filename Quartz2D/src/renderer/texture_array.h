@@ -0,0 +1,40 @@
+#pragma once
+
+#include <common.h>
+#include <renderer/texture_atlas.h>
+
+#include <glad/glad.h>
+
+// Textures are uploaded into GL_TEXTURE_2D_ARRAY pages owned by the renderer. Every page has square
+// layers of one size class and each layer is an atlas: textures are skyline packed into it as they are
+// loaded, with an extruded border so neighbours never bleed into each other. Everything up to the atlas
+// size shares the same pages, larger textures get a class of their own. The i32 texture ids used
+// everywhere else are handles into this table, so a single bound page serves every texture in it and
+// a batch can reference hundreds of textures through its 8 slots.
+
+#define TEXTURE_ARRAY_MAX_PAGES 64
+#define TEXTURE_ARRAY_MAX_LAYERS 256  // Layers fit in a u8 vertex attribute
+
+typedef struct {
+    u16 page;
+    u16 layer;
+    i32 width;
+    i32 height;
+    uv_rect rect;  // Area of the layer the texture covers, uv rects of the texture are remapped into it
+    i32 next_free; // Free list link while the handle is unused
+} texture_array_entry;
+
+u8 texture_array_init(u8 cpu_pages); // CPU pages keep the pixels in memory instead of GL textures, for the software rasterizer
+void texture_array_shutdown();
+
+// Pixels are RGBA8, returns -1 if the texture is larger than the GPU allows or every page is full
+i32 texture_array_create(i32 width, i32 height, const u8* pixels);
+void texture_array_destroy(i32 texture);
+i32 texture_array_max_size(); // Largest width and height texture_array_create accepts
+
+const texture_array_entry* texture_array_get(i32 texture); // NULL for -1 or a destroyed texture
+GLuint texture_array_page_texture(u32 page);
+const u8* texture_array_page_pixels(u32 page, u32 layer, i32* out_size); // RGBA8 rows from v = 0, NULL unless the pages are CPU pages
+
+// Sorts textures by page then layer, 0 for no texture, fits in 16 bits
+u32 texture_array_sort_key(i32 texture);
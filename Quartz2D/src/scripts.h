@@ -2,11 +2,17 @@
 
 #include <common.h>
 #include <ECS/ecs.h>
+#include <ECS/scheduler.h>
 
 extern const int WIDTH;
 extern const int HEIGHT;
 extern const int UPSCALE_MULTIPLIER;
 
-void draw_blasts(entity_id id, u32 index);
-void blast_on_update(entity_id entity, f32 delta_time);
+#define COLLISION_LAYER_ENEMY (1 << 0)
+#define COLLISION_LAYER_BLAST (1 << 1)
+
+void draw_blasts(const ecs_system_context* ctx);
+void cull_blasts(const ecs_system_context* ctx);
+void update_collisions(const ecs_system_context* ctx); // user_data is the ecs_broadphase
+void resolve_blast_hits(const ecs_system_context* ctx); // user_data is the ecs_broadphase
 void my_script_on_update(entity_id entity, f32 delta_time);
\ No newline at end of file